@@ -6,6 +6,18 @@
 #include <list>
 #include <exception>
 #include <iterator>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <memory>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 #ifndef EXCLUDE_QT
 #include <QMainWindow>
 #include <QApplication>
@@ -0,0 +1,216 @@
+#include "antichain_inclusion.h"
+
+AntichainInclusion::AntichainInclusion(const CompactAutomata &left,
+                                       const CompactAutomata &right,
+                                       shared_ptr<const EpsilonClosure> left_closure,
+                                       shared_ptr<const EpsilonClosure> right_closure):
+    left(left), right(right), count(left.size()+right.size()),
+    final_states(left.size()+right.size()) {
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    set<char> alphabet;
+    for (uint32_t column = 0; column < left.symbolCount(); column++) {
+        alphabet.insert(left.symbolAt(column));
+    }
+    for (uint32_t column = 0; column < right.symbolCount(); column++) {
+        alphabet.insert(right.symbolAt(column));
+    }
+    symbols.assign(alphabet.begin(), alphabet.end());
+    // The transitions of each state are the transitions of its epsilon
+    // closure, and it is final if its closure has a final state
+    offsets.assign((size_t) count*symbols.size()+1, 0);
+    if (!left_closure) {
+        left_closure = make_shared<EpsilonClosure>(left);
+    }
+    if (!right_closure) {
+        right_closure = make_shared<EpsilonClosure>(right);
+    }
+    vector<uint32_t> row;
+    for (uint32_t state = 0; state < count; state++) {
+        const CompactAutomata &automata = state < left.size() ? left : right;
+        uint32_t shift = state < left.size() ? 0 : left.size();
+        StateRange closure = state < left.size() ? left_closure->closure(state) :
+            right_closure->closure(state-shift);
+        for (uint32_t member: closure) {
+            if (automata.isFinalState(member)) {
+                final_states.insert(state);
+            }
+        }
+        for (uint32_t symbol = 0; symbol < symbols.size(); symbol++) {
+            uint32_t column = automata.symbolColumn(symbols[symbol]);
+            row.clear();
+            if (column != NONE) {
+                for (uint32_t member: closure) {
+                    for (uint32_t target: automata.successors(member, column)) {
+                        row.push_back(shift+target);
+                    }
+                }
+            }
+            sort(row.begin(), row.end());
+            row.erase(unique(row.begin(), row.end()), row.end());
+            targets.insert(targets.end(), row.begin(), row.end());
+            offsets[(size_t) state*symbols.size()+symbol+1] = targets.size();
+        }
+    }
+    simulate();
+}
+
+StateRange AntichainInclusion::successors(uint32_t state, uint32_t symbol) const {
+    size_t row = (size_t) state*symbols.size()+symbol;
+    const uint32_t *data = targets.data();
+    return StateRange(data+offsets[row], data+offsets[row+1]);
+}
+
+void AntichainInclusion::simulate() {
+    // Start with the pairs that respect the final states and the symbols
+    // with some transition, then remove the pairs that do not respect the
+    // transitions until nothing changes
+    simulators.assign(count, StateSet(count));
+    for (uint32_t state = 0; state < count; state++) {
+        for (uint32_t simulator = 0; simulator < count; simulator++) {
+            if (final_states.contains(state) && !final_states.contains(simulator)) {
+                continue;
+            }
+            bool valid = true;
+            for (uint32_t symbol = 0; valid && symbol < symbols.size(); symbol++) {
+                valid = successors(state, symbol).empty() ||
+                    !successors(simulator, symbol).empty();
+            }
+            if (valid) {
+                simulators[state].insert(simulator);
+            }
+        }
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t state = 0; state < count; state++) {
+            for (uint32_t simulator: simulators[state].elements()) {
+                if (simulator == state) {
+                    continue;
+                }
+                bool valid = true;
+                for (uint32_t symbol = 0; valid && symbol < symbols.size(); symbol++) {
+                    StateRange answers = successors(simulator, symbol);
+                    for (uint32_t target: successors(state, symbol)) {
+                        valid = false;
+                        for (uint32_t answer: answers) {
+                            if (simulators[target].contains(answer)) {
+                                valid = true;
+                                break;
+                            }
+                        }
+                        if (!valid) {
+                            break;
+                        }
+                    }
+                }
+                if (!valid) {
+                    simulators[state].erase(simulator);
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+bool AntichainInclusion::isSimulated(uint32_t state, uint32_t simulator) const {
+    return simulators[state].contains(simulator);
+}
+
+bool AntichainInclusion::isSimulated(const StateSet &states,
+                                     const StateSet &simulators) const {
+    bool result = true;
+    states.forEach([&](uint32_t state) {
+        result = result && this->simulators[state].intersects(simulators);
+    });
+    return result;
+}
+
+void AntichainInclusion::reduce(StateSet &states) const {
+    for (uint32_t state: states.elements()) {
+        bool dominated = false;
+        states.forEach([&](uint32_t other) {
+            if (other != state && isSimulated(state, other) &&
+                (!isSimulated(other, state) || other < state)) {
+                dominated = true;
+            }
+        });
+        if (dominated) {
+            states.erase(state);
+        }
+    }
+}
+
+bool AntichainInclusion::isContained(string &counterexample) const {
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    if (left.initialState() == NONE) {
+        return true;
+    }
+    StateSet initial(count);
+    if (right.initialState() != NONE) {
+        initial.insert(left.size()+right.initialState());
+    }
+    reduce(initial);
+    // The visited pairs, with the pair that discovered each of them, so the
+    // vector is also the queue of the breadth-first search
+    vector<pair<uint32_t, StateSet> > pairs;
+    vector<pair<uint32_t, uint32_t> > parents;
+    vector<vector<uint32_t> > visited(left.size());
+    auto visit = [&](uint32_t state, const StateSet &states,
+                     uint32_t parent, uint32_t symbol) {
+        // A pair where the state is simulated by a state of the set can
+        // never fail
+        if (simulators[state].intersects(states)) {
+            return;
+        }
+        bool subsumed = false;
+        for (uint32_t other = 0; !subsumed && other < left.size(); other++) {
+            if (!isSimulated(state, other)) {
+                continue;
+            }
+            for (uint32_t index: visited[other]) {
+                if (isSimulated(pairs[index].second, states)) {
+                    subsumed = true;
+                    break;
+                }
+            }
+        }
+        if (subsumed) {
+            return;
+        }
+        visited[state].push_back(pairs.size());
+        pairs.push_back(make_pair(state, states));
+        parents.push_back(make_pair(parent, symbol));
+    };
+    visit(left.initialState(), initial, NONE, NONE);
+    StateSet next(count);
+    for (uint32_t index = 0; index < pairs.size(); index++) {
+        uint32_t state = pairs[index].first;
+        if (final_states.contains(state) &&
+            !pairs[index].second.intersects(final_states)) {
+            counterexample.clear();
+            for (uint32_t i = index; parents[i].first != NONE; i = parents[i].first) {
+                counterexample.push_back(symbols[parents[i].second]);
+            }
+            reverse(counterexample.begin(), counterexample.end());
+            return false;
+        }
+        for (uint32_t symbol = 0; symbol < symbols.size(); symbol++) {
+            StateRange targets = successors(state, symbol);
+            if (targets.empty()) {
+                continue;
+            }
+            next.clear();
+            pairs[index].second.forEach([&](uint32_t member) {
+                for (uint32_t target: successors(member, symbol)) {
+                    next.insert(target);
+                }
+            });
+            reduce(next);
+            for (uint32_t target: targets) {
+                visit(target, next, index, symbol);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,110 @@
+#ifndef ANTICHAIN_INCLUSION_H
+#define ANTICHAIN_INCLUSION_H
+
+#include "all.h"
+#include "compact_automata.h"
+#include "state_set.h"
+#include "epsilon_closure.h"
+
+/*!
+ * This class checks if the language of a nondeterministic automata is
+ * contained in the language of another one without determinizing any of them,
+ * using the antichain algorithm with simulation subsumption (from Abdulla,
+ * Chen, Holík, Mayr and Vojnar).
+ *
+ * The search explores pairs (p, P), where p is a state of the left automata
+ * and P is the set of states of the right automata reached by the same word.
+ * A pair fails when p is final and P has no final state. Using the maximal
+ * forward simulation of the disjoint union of both automata (where a state
+ * simulated by another accepts a subset of its language):
+ *
+ * - the states of P simulated by another state of P are dropped;
+ * - a pair where p is simulated by some state of P can never fail;
+ * - a pair (p, P) is skipped when some visited pair (r, R) has p simulated by
+ *   r and every state of R simulated by some state of P, because if (p, P)
+ *   fails, (r, R) fails too.
+ *
+ * Epsilon transitions are removed on the fly, so the automata may have them.
+ */
+class AntichainInclusion {
+public:
+    /*!
+     * Constructs an inclusion check between two compiled automata
+     *
+     * @param left          The automata whose language should be contained
+     * @param right         The automata whose language should contain the
+     *                      other one
+     * @param left_closure  The epsilon closures of the left automata, which
+     *                      are computed if they are not passed
+     * @param right_closure The epsilon closures of the right automata, which
+     *                      are computed if they are not passed
+     */
+    AntichainInclusion(const CompactAutomata &left, const CompactAutomata &right,
+                       shared_ptr<const EpsilonClosure> left_closure = nullptr,
+                       shared_ptr<const EpsilonClosure> right_closure = nullptr);
+
+    /*!
+     * Check if the language of the left automata is contained in the language
+     * of the right automata
+     *
+     * @param counterexample Receives a word accepted by the left automata but
+     *                       not by the right automata, when there is one
+     * @return true if the language is contained, false otherwise
+     */
+    bool isContained(string &counterexample) const;
+
+    /*!
+     * Check if a state of the disjoint union (where the states of the right
+     * automata come after the states of the left automata) is simulated by
+     * another one
+     *
+     * @param state     The state that should be simulated
+     * @param simulator The state that should simulate it
+     * @return true if the state is simulated, false otherwise
+     */
+    bool isSimulated(uint32_t state, uint32_t simulator) const;
+
+protected:
+    /*!
+     * Return the targets of the transitions of a state of the disjoint union
+     * without epsilon transitions
+     *
+     * @param state  The source state
+     * @param symbol The index of the symbol
+     * @return The target states
+     */
+    StateRange successors(uint32_t state, uint32_t symbol) const;
+
+    /*!
+     * Compute the maximal forward simulation of the disjoint union by
+     * refining the relation until every pair respects the transitions
+     */
+    void simulate();
+
+    /*!
+     * Remove from a set the states simulated by another state of the same set
+     * (keeping the smallest of the states that simulate each other)
+     *
+     * @param states The set of states to reduce
+     */
+    void reduce(StateSet &states) const;
+
+    /*!
+     * Check if every state of a set is simulated by some state of another set
+     *
+     * @param states     The states that should be simulated
+     * @param simulators The states that should simulate them
+     * @return true if every state is simulated, false otherwise
+     */
+    bool isSimulated(const StateSet &states, const StateSet &simulators) const;
+
+    const CompactAutomata &left; //!< The automata on the left side
+    const CompactAutomata &right; //!< The automata on the right side
+    vector<char> symbols; //!< The union of the alphabets
+    uint32_t count; //!< The number of states of the disjoint union
+    StateSet final_states; //!< The states that reach a final state by epsilon
+    vector<uint32_t> offsets; //!< Offsets of the transitions, indexed by state*symbols+symbol
+    vector<uint32_t> targets; //!< The targets of the transitions without epsilon
+    vector<StateSet> simulators; //!< The states that simulate each state
+};
+#endif // ANTICHAIN_INCLUSION_H
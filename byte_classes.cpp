@@ -0,0 +1,115 @@
+#include "byte_classes.h"
+
+ByteClasses::ByteClasses(): classes(256, 0), sizes(1, 256), firsts(1, 0) {}
+
+void ByteClasses::split(const StateSet &bytes) {
+    // A class is split only when the set has some of its bytes but not all
+    vector<uint32_t> inside(sizes.size(), 0);
+    bytes.forEach([&](uint32_t byte) {
+        inside[classes[byte]]++;
+    });
+    vector<uint32_t> renamed(sizes.size(), UINT32_MAX);
+    vector<uint32_t> totals = sizes;
+    bytes.forEach([&](uint32_t byte) {
+        uint32_t current = classes[byte];
+        if (inside[current] == totals[current]) {
+            return;
+        }
+        if (renamed[current] == UINT32_MAX) {
+            renamed[current] = sizes.size();
+            sizes.push_back(0);
+            firsts.push_back(byte);
+        }
+        classes[byte] = renamed[current];
+        sizes[current]--;
+        sizes[renamed[current]]++;
+    });
+    // The bytes left in a split class may start after the ones moved out
+    for (uint32_t byte = 256; byte-- > 0;) {
+        firsts[classes[byte]] = byte;
+    }
+}
+
+uint32_t ByteClasses::count() const {
+    return sizes.size();
+}
+
+char ByteClasses::representative(char byte) const {
+    return firsts[classes[(unsigned char) byte]];
+}
+
+vector<char> ByteClasses::representatives(const StateSet &bytes) const {
+    vector<char> result;
+    bytes.forEach([&](uint32_t byte) {
+        if (firsts[classes[byte]] == byte) {
+            result.push_back(byte);
+        }
+    });
+    return result;
+}
+
+StateSet ByteClasses::members(char byte) const {
+    StateSet result(256);
+    uint32_t target = classes[(unsigned char) byte];
+    for (uint32_t other = 0; other < 256; other++) {
+        if (classes[other] == target) {
+            result.insert(other);
+        }
+    }
+    return result;
+}
+
+string ByteClasses::translate(const string &word) const {
+    string result(word.size(), 0);
+    for (size_t i = 0; i < word.size(); i++) {
+        result[i] = representative(word[i]);
+    }
+    return result;
+}
+
+CompactAutomata ByteClasses::expand(const CompactAutomata &automata) const {
+    bool singletons = true;
+    for (uint32_t column = 0; column < automata.symbolCount(); column++) {
+        char symbol = automata.symbolAt(column);
+        singletons = singletons && symbol != FiniteAutomata::EPSILON &&
+                sizes[classes[(unsigned char) symbol]] == 1;
+    }
+    if (singletons) {
+        return automata;
+    }
+    // The bytes of each column, in the same order as the alphabet
+    CompactAutomata result;
+    vector<vector<uint32_t>> columns(automata.symbolCount());
+    vector<pair<char, uint32_t>> bytes;
+    for (uint32_t column = 0; column < automata.symbolCount(); column++) {
+        members(automata.symbolAt(column)).forEach([&](uint32_t byte) {
+            if ((char) byte != FiniteAutomata::EPSILON) {
+                bytes.push_back(make_pair((char) byte, column));
+            }
+        });
+    }
+    sort(bytes.begin(), bytes.end());
+    for (auto &byte: bytes) {
+        columns[byte.second].push_back(result.addSymbol(byte.first));
+    }
+    for (uint32_t state = 0; state < automata.size(); state++) {
+        result.addState(automata.stateName(state), automata.isFinalState(state));
+    }
+    if (automata.initialState() != CompactAutomata::NO_STATE) {
+        result.setInitialState(automata.initialState());
+    }
+    for (uint32_t state = 0; state < automata.size(); state++) {
+        for (uint32_t column = 0; column < automata.symbolCount(); column++) {
+            for (uint32_t target: automata.successors(state, column)) {
+                for (uint32_t expanded: columns[column]) {
+                    result.addTransition(state, expanded, target);
+                }
+            }
+        }
+        for (uint32_t target: automata.epsilonSuccessors(state)) {
+            result.addEpsilonTransition(state, target);
+        }
+    }
+    result.compile();
+    return result;
+}
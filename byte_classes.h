@@ -0,0 +1,92 @@
+#ifndef BYTE_CLASSES_H
+#define BYTE_CLASSES_H
+
+#include "all.h"
+#include "state_set.h"
+#include "compact_automata.h"
+#include "finite_automata.h"
+
+/*!
+ * A partition of the 256 bytes in equivalence classes: two bytes are in the
+ * same class when every set of bytes used by a regular expression (each
+ * literal, each character class and the '.') has both or none of them, so
+ * the expression can not tell them apart.
+ *
+ * Each class is represented by its smallest byte. The trees, positions and
+ * automata of a regular expression only use the representatives, so their
+ * transition tables have a column per class instead of one per byte, and the
+ * words are translated to representatives before they are matched. The bytes
+ * that are not in any set share a class whose representative is never used,
+ * so they are rejected.
+ */
+class ByteClasses {
+public:
+    /*!
+     * Constructs the partition with all the bytes in the same class
+     */
+    ByteClasses();
+
+    /*!
+     * Split the classes so a set of bytes is a union of classes
+     *
+     * @param bytes The set of bytes (with capacity 256)
+     */
+    void split(const StateSet &bytes);
+
+    /*!
+     * Return the number of classes
+     *
+     * @return The number of classes
+     */
+    uint32_t count() const;
+
+    /*!
+     * Return the representative of the class of a byte
+     *
+     * @param byte The byte
+     * @return The smallest byte of its class
+     */
+    char representative(char byte) const;
+
+    /*!
+     * Return the representatives of the classes of a set of bytes, which must
+     * be a union of classes
+     *
+     * @param bytes The set of bytes (with capacity 256)
+     * @return The representatives, in increasing order of byte
+     */
+    vector<char> representatives(const StateSet &bytes) const;
+
+    /*!
+     * Return the bytes of the class of a byte
+     *
+     * @param byte The byte
+     * @return The bytes of its class (with capacity 256)
+     */
+    StateSet members(char byte) const;
+
+    /*!
+     * Replace each byte of a word by its representative
+     *
+     * @param word The word
+     * @return The translated word
+     */
+    string translate(const string &word) const;
+
+    /*!
+     * Build an automata over bytes from an automata over representatives:
+     * each transition by a representative is copied to the other bytes of
+     * its class. The byte FiniteAutomata::EPSILON is left out, since it marks
+     * the epsilon transitions of FiniteAutomata.
+     *
+     * @param automata The automata over representatives
+     * @return The automata over bytes
+     */
+    CompactAutomata expand(const CompactAutomata &automata) const;
+
+private:
+    vector<uint32_t> classes; //!< The class of each byte
+    vector<uint32_t> sizes; //!< The number of bytes of each class
+    vector<unsigned char> firsts; //!< The representative of each class
+};
+#endif // BYTE_CLASSES_H
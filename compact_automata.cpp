@@ -0,0 +1,315 @@
+#include "compact_automata.h"
+
+StateRange::StateRange(const uint32_t *first, const uint32_t *last):
+    first(first), last(last) {}
+
+const uint32_t *StateRange::begin() const {
+    return first;
+}
+
+const uint32_t *StateRange::end() const {
+    return last;
+}
+
+uint32_t StateRange::size() const {
+    return last - first;
+}
+
+bool StateRange::empty() const {
+    return first == last;
+}
+
+const uint32_t CompactAutomata::NO_STATE = UINT32_MAX;
+
+const uint32_t CompactAutomata::NO_SYMBOL = UINT32_MAX;
+
+CompactAutomata::CompactAutomata(): columns(256, NO_SYMBOL), initial(NO_STATE),
+    compiled_states(0), compiled_columns(0) {}
+
+uint32_t CompactAutomata::addSymbol(char symbol) {
+    uint32_t &column = columns[(unsigned char) symbol];
+    if (column == NO_SYMBOL) {
+        column = symbols.size();
+        symbols.push_back(symbol);
+    }
+    return column;
+}
+
+uint32_t CompactAutomata::addState(const string &name, bool final) {
+    if (!name.empty()) {
+        auto it = ids.find(name);
+        if (it != ids.end()) {
+            if (final) {
+                finals[it->second] = true;
+            }
+            return it->second;
+        }
+        ids[name] = names.size();
+    }
+    names.push_back(name);
+    finals.push_back(final);
+    return names.size()-1;
+}
+
+void CompactAutomata::setStateName(uint32_t state, const string &name) {
+    names[state] = name;
+    ids[name] = state;
+}
+
+void CompactAutomata::setInitialState(uint32_t state) {
+    initial = state;
+}
+
+void CompactAutomata::setFinalState(uint32_t state, bool final) {
+    finals[state] = final;
+}
+
+void CompactAutomata::addTransition(uint32_t source, uint32_t column, uint32_t target) {
+    Edge edge = {source, column, target};
+    edges.push_back(edge);
+}
+
+void CompactAutomata::addEpsilonTransition(uint32_t source, uint32_t target) {
+    Edge edge = {source, NO_SYMBOL, target};
+    edges.push_back(edge);
+}
+
+template <typename Key>
+void CompactAutomata::buildRows(const vector<Edge> &edges, size_t rows, Key key,
+                                vector<uint32_t> &offsets, vector<uint32_t> &targets) {
+    // Counting sort of the edges by row, followed by a sort (and merge of
+    // repeated targets) inside each row, which are usually tiny
+    vector<uint32_t> counts(rows+1, 0);
+    for (const Edge &edge: edges) {
+        counts[key(edge)+1]++;
+    }
+    for (size_t row = 0; row < rows; row++) {
+        counts[row+1] += counts[row];
+    }
+    vector<uint32_t> sorted(counts[rows]);
+    vector<uint32_t> next(counts.begin(), counts.end()-1);
+    for (const Edge &edge: edges) {
+        sorted[next[key(edge)]++] = edge.target;
+    }
+    offsets.assign(rows+1, 0);
+    targets.clear();
+    targets.reserve(sorted.size());
+    for (size_t row = 0; row < rows; row++) {
+        auto first = sorted.begin()+counts[row];
+        auto last = sorted.begin()+counts[row+1];
+        sort(first, last);
+        last = unique(first, last);
+        targets.insert(targets.end(), first, last);
+        offsets[row+1] = targets.size();
+    }
+}
+
+void CompactAutomata::compile() {
+    // Bring back the transitions of a previous compilation, as the number of
+    // states and columns (and so the layout of the rows) may have changed
+    for (uint32_t state = 0; state < compiled_states; state++) {
+        for (uint32_t column = 0; column < compiled_columns; column++) {
+            size_t row = (size_t) state*compiled_columns+column;
+            for (uint32_t i = offsets[row]; i < offsets[row+1]; i++) {
+                Edge edge = {state, column, targets[i]};
+                edges.push_back(edge);
+            }
+        }
+        for (uint32_t i = epsilon_offsets[state]; i < epsilon_offsets[state+1]; i++) {
+            Edge edge = {state, NO_SYMBOL, epsilon_targets[i]};
+            edges.push_back(edge);
+        }
+    }
+    vector<Edge> symbolEdges, epsilonEdges;
+    for (const Edge &edge: edges) {
+        if (edge.column == NO_SYMBOL) {
+            epsilonEdges.push_back(edge);
+        } else {
+            symbolEdges.push_back(edge);
+        }
+    }
+    edges.clear();
+    edges.shrink_to_fit();
+    compiled_states = size();
+    compiled_columns = symbolCount();
+    size_t width = compiled_columns;
+    buildRows(symbolEdges, (size_t) compiled_states*width,
+              [width](const Edge &edge) {
+                  return (size_t) edge.source*width+edge.column;
+              },
+              offsets, targets);
+    buildRows(epsilonEdges, compiled_states,
+              [](const Edge &edge) {
+                  return (size_t) edge.source;
+              },
+              epsilon_offsets, epsilon_targets);
+    // The reverse index is built from the same edges, with the source and
+    // the target swapped
+    for (Edge &edge: symbolEdges) {
+        swap(edge.source, edge.target);
+    }
+    for (Edge &edge: epsilonEdges) {
+        swap(edge.source, edge.target);
+    }
+    buildRows(symbolEdges, (size_t) compiled_states*width,
+              [width](const Edge &edge) {
+                  return (size_t) edge.source*width+edge.column;
+              },
+              reverse_offsets, reverse_sources);
+    buildRows(epsilonEdges, compiled_states,
+              [](const Edge &edge) {
+                  return (size_t) edge.source;
+              },
+              epsilon_reverse_offsets, epsilon_reverse_sources);
+}
+
+uint32_t CompactAutomata::size() const {
+    return names.size();
+}
+
+uint32_t CompactAutomata::symbolCount() const {
+    return symbols.size();
+}
+
+char CompactAutomata::symbolAt(uint32_t column) const {
+    return symbols[column];
+}
+
+uint32_t CompactAutomata::symbolColumn(char symbol) const {
+    return columns[(unsigned char) symbol];
+}
+
+uint32_t CompactAutomata::initialState() const {
+    return initial;
+}
+
+bool CompactAutomata::isFinalState(uint32_t state) const {
+    return finals[state];
+}
+
+const string &CompactAutomata::stateName(uint32_t state) const {
+    return names[state];
+}
+
+uint32_t CompactAutomata::findState(const string &name) const {
+    auto it = ids.find(name);
+    if (it == ids.end()) {
+        return NO_STATE;
+    }
+    return it->second;
+}
+
+StateRange CompactAutomata::successors(uint32_t state, uint32_t column) const {
+    size_t row = (size_t) state*compiled_columns+column;
+    const uint32_t *base = targets.data();
+    return StateRange(base+offsets[row], base+offsets[row+1]);
+}
+
+uint32_t CompactAutomata::successor(uint32_t state, uint32_t column) const {
+    size_t row = (size_t) state*compiled_columns+column;
+    if (offsets[row] == offsets[row+1]) {
+        return NO_STATE;
+    }
+    return targets[offsets[row]];
+}
+
+StateRange CompactAutomata::epsilonSuccessors(uint32_t state) const {
+    const uint32_t *base = epsilon_targets.data();
+    return StateRange(base+epsilon_offsets[state], base+epsilon_offsets[state+1]);
+}
+
+StateRange CompactAutomata::predecessors(uint32_t state, uint32_t column) const {
+    size_t row = (size_t) state*compiled_columns+column;
+    const uint32_t *base = reverse_sources.data();
+    return StateRange(base+reverse_offsets[row], base+reverse_offsets[row+1]);
+}
+
+StateRange CompactAutomata::epsilonPredecessors(uint32_t state) const {
+    const uint32_t *base = epsilon_reverse_sources.data();
+    return StateRange(base+epsilon_reverse_offsets[state],
+                      base+epsilon_reverse_offsets[state+1]);
+}
+
+bool CompactAutomata::hasEpsilonTransitions() const {
+    return !epsilon_targets.empty();
+}
+
+bool CompactAutomata::isDeterministic() const {
+    if (hasEpsilonTransitions()) {
+        return false;
+    }
+    size_t rows = (size_t) compiled_states*compiled_columns;
+    for (size_t row = 0; row < rows; row++) {
+        if (offsets[row+1]-offsets[row] > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CompactAutomata::expandClosure(vector<uint32_t> &states, vector<bool> &marks) const {
+    for (size_t i = 0; i < states.size(); i++) {
+        for (uint32_t target: epsilonSuccessors(states[i])) {
+            if (marks[target]) {
+                continue;
+            }
+            marks[target] = true;
+            states.push_back(target);
+        }
+    }
+}
+
+vector<bool> CompactAutomata::reachableStates() const {
+    vector<bool> marks(compiled_states, false);
+    if (initial == NO_STATE) {
+        return marks;
+    }
+    vector<uint32_t> queue(1, initial);
+    marks[initial] = true;
+    for (size_t i = 0; i < queue.size(); i++) {
+        // The rows of a state are contiguous, so all its targets (but the
+        // epsilon ones) are in a single range
+        size_t row = (size_t) queue[i]*compiled_columns;
+        for (uint32_t j = offsets[row]; j < offsets[row+compiled_columns]; j++) {
+            if (!marks[targets[j]]) {
+                marks[targets[j]] = true;
+                queue.push_back(targets[j]);
+            }
+        }
+        for (uint32_t target: epsilonSuccessors(queue[i])) {
+            if (!marks[target]) {
+                marks[target] = true;
+                queue.push_back(target);
+            }
+        }
+    }
+    return marks;
+}
+
+vector<bool> CompactAutomata::coreachableStates() const {
+    vector<bool> marks(compiled_states, false);
+    vector<uint32_t> queue;
+    for (uint32_t state = 0; state < compiled_states; state++) {
+        if (finals[state]) {
+            marks[state] = true;
+            queue.push_back(state);
+        }
+    }
+    for (size_t i = 0; i < queue.size(); i++) {
+        size_t row = (size_t) queue[i]*compiled_columns;
+        for (uint32_t j = reverse_offsets[row];
+             j < reverse_offsets[row+compiled_columns]; j++) {
+            if (!marks[reverse_sources[j]]) {
+                marks[reverse_sources[j]] = true;
+                queue.push_back(reverse_sources[j]);
+            }
+        }
+        for (uint32_t source: epsilonPredecessors(queue[i])) {
+            if (!marks[source]) {
+                marks[source] = true;
+                queue.push_back(source);
+            }
+        }
+    }
+    return marks;
+}
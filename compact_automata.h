@@ -0,0 +1,320 @@
+#ifndef COMPACT_AUTOMATA_H
+#define COMPACT_AUTOMATA_H
+
+#include "all.h"
+
+/*!
+ * A read-only view over a contiguous range of state IDs, as returned by the
+ * transition lookups of a CompactAutomata
+ */
+class StateRange {
+    public:
+        /*!
+         * Constructs a range between two pointers of the same array
+         *
+         * @param first The first state of the range
+         * @param last  One past the last state of the range
+         */
+        StateRange(const uint32_t *first, const uint32_t *last);
+
+        /*!
+         * The first state of the range (compatible with range-based for)
+         */
+        const uint32_t *begin() const;
+
+        /*!
+         * One past the last state of the range (compatible with range-based
+         * for)
+         */
+        const uint32_t *end() const;
+
+        /*!
+         * The number of states in the range
+         */
+        uint32_t size() const;
+
+        /*!
+         * Check if the range does not have any state
+         *
+         * @return true if the range is empty, false otherwise
+         */
+        bool empty() const;
+    private:
+        const uint32_t *first; //!< The first state of the range
+        const uint32_t *last; //!< One past the last state of the range
+};
+
+/*!
+ * This class is the compact core used by the algorithms of FiniteAutomata.
+ *
+ * States are identified by dense uint32_t IDs, the names of the states are
+ * interned in a table (so they are only needed when converting back to the
+ * string API) and the transitions are stored in flat arrays, indexed by
+ * (state, symbol column), in the compressed sparse row format.
+ *
+ * The automata is built in two phases: first the states, symbols and
+ * transitions are added, and then compile() builds the flat arrays. The
+ * transition lookups are only valid after compile() is called.
+ */
+class CompactAutomata {
+public:
+    /*!
+     * Constructs an empty compact automata, without states or symbols
+     */
+    CompactAutomata();
+
+    /*!
+     * Add a symbol to the alphabet of this automata, returning the column
+     * used to index the transitions by that symbol. Adding a symbol that
+     * already exists just returns its column.
+     *
+     * @param symbol The symbol to add
+     * @return The column of the symbol
+     */
+    uint32_t addSymbol(char symbol);
+
+    /*!
+     * Add a new state to the automata
+     *
+     * @param name  The name of the state, or an empty string for an anonymous
+     *              state
+     * @param final If the state is final or not
+     * @return The ID of the new state (or the ID of the existing state, if
+     * there is already a state with that name)
+     */
+    uint32_t addState(const string &name = "", bool final = false);
+
+    /*!
+     * Give a name to a state that is still anonymous
+     *
+     * @param state The ID of the state
+     * @param name  The new name of the state, which must not be in use
+     */
+    void setStateName(uint32_t state, const string &name);
+
+    /*!
+     * Set the initial state of the automata
+     *
+     * @param state The ID of the initial state
+     */
+    void setInitialState(uint32_t state);
+
+    /*!
+     * Mark (or unmark) a state as final
+     *
+     * @param state The ID of the state
+     * @param final If the state should be final or not
+     */
+    void setFinalState(uint32_t state, bool final = true);
+
+    /*!
+     * Add a transition by a symbol column between two states
+     *
+     * @param source The ID of the source state
+     * @param column The column of the symbol
+     * @param target The ID of the target state
+     */
+    void addTransition(uint32_t source, uint32_t column, uint32_t target);
+
+    /*!
+     * Add an epsilon transition between two states
+     *
+     * @param source The ID of the source state
+     * @param target The ID of the target state
+     */
+    void addEpsilonTransition(uint32_t source, uint32_t target);
+
+    /*!
+     * Build the flat transition arrays from the transitions added so far.
+     * Repeated transitions are merged. It is safe to add more states, symbols
+     * and transitions and compile the automata again.
+     */
+    void compile();
+
+    /*!
+     * Return the number of states of this automata
+     */
+    uint32_t size() const;
+
+    /*!
+     * Return the number of symbol columns of this automata
+     */
+    uint32_t symbolCount() const;
+
+    /*!
+     * Return the symbol represented by a column
+     *
+     * @param column The column of the symbol
+     * @return The symbol of that column
+     */
+    char symbolAt(uint32_t column) const;
+
+    /*!
+     * Return the column used by a symbol
+     *
+     * @param symbol The symbol to search
+     * @return The column of the symbol or NO_SYMBOL if the symbol is not in
+     * the alphabet
+     */
+    uint32_t symbolColumn(char symbol) const;
+
+    /*!
+     * Return the ID of the initial state, or NO_STATE if it is not defined
+     */
+    uint32_t initialState() const;
+
+    /*!
+     * Check if a state is final
+     *
+     * @param state The ID of the state to check
+     * @return true if the state is final, false otherwise
+     */
+    bool isFinalState(uint32_t state) const;
+
+    /*!
+     * Return the name of a state, which is empty for anonymous states
+     *
+     * @param state The ID of the state
+     * @return The name of the state
+     */
+    const string &stateName(uint32_t state) const;
+
+    /*!
+     * Return the ID of a state given its name
+     *
+     * @param name The name of the state
+     * @return The ID of the state, or NO_STATE if there is no such state
+     */
+    uint32_t findState(const string &name) const;
+
+    /*!
+     * Return the states reachable from a state by a symbol column
+     *
+     * @param state  The ID of the source state
+     * @param column The column of the symbol
+     * @return The range of target states, ordered by ID
+     */
+    StateRange successors(uint32_t state, uint32_t column) const;
+
+    /*!
+     * Return the single state reachable from a state by a symbol column,
+     * which is useful on deterministic automata
+     *
+     * @param state  The ID of the source state
+     * @param column The column of the symbol
+     * @return The first target state, or NO_STATE if there is none
+     */
+    uint32_t successor(uint32_t state, uint32_t column) const;
+
+    /*!
+     * Return the states reachable from a state by a single epsilon transition
+     *
+     * @param state The ID of the source state
+     * @return The range of target states, ordered by ID
+     */
+    StateRange epsilonSuccessors(uint32_t state) const;
+
+    /*!
+     * Return the states that reach a state by a symbol column
+     *
+     * @param state  The ID of the target state
+     * @param column The column of the symbol
+     * @return The range of source states, ordered by ID
+     */
+    StateRange predecessors(uint32_t state, uint32_t column) const;
+
+    /*!
+     * Return the states that reach a state by a single epsilon transition
+     *
+     * @param state The ID of the target state
+     * @return The range of source states, ordered by ID
+     */
+    StateRange epsilonPredecessors(uint32_t state) const;
+
+    /*!
+     * Check if this automata has any epsilon transition
+     *
+     * @return true if there is at least one epsilon transition
+     */
+    bool hasEpsilonTransitions() const;
+
+    /*!
+     * Check if this automata is deterministic in the strict sense: it does
+     * not have epsilon transitions and each state has at most one transition
+     * per symbol
+     *
+     * @return true if the automata is strictly deterministic, false otherwise
+     */
+    bool isDeterministic() const;
+
+    /*!
+     * Add to a list the states reachable by epsilon transitions from the
+     * states already in that list
+     *
+     * @param states The list of states to expand, which must not have
+     *               repeated states
+     * @param marks  A vector with size() elements, where the states of the
+     *               list are marked. It is updated with the new states.
+     */
+    void expandClosure(vector<uint32_t> &states, vector<bool> &marks) const;
+
+    /*!
+     * Return the states reachable from the initial state, in linear time
+     *
+     * @return If each state is reachable, indexed by ID
+     */
+    vector<bool> reachableStates() const;
+
+    /*!
+     * Return the states that reach some final state (the states that are not
+     * dead), in linear time using the reverse transitions
+     *
+     * @return If each state reaches a final state, indexed by ID
+     */
+    vector<bool> coreachableStates() const;
+
+    const static uint32_t NO_STATE; //!< Constant used when there is no state
+    const static uint32_t NO_SYMBOL; //!< Constant used when there is no symbol
+private:
+    /*!
+     * A transition waiting for the call to compile()
+     */
+    struct Edge {
+        uint32_t source; //!< The ID of the source state
+        uint32_t column; //!< The column of the symbol (or NO_SYMBOL for epsilon)
+        uint32_t target; //!< The ID of the target state
+    };
+
+    /*!
+     * Build one compressed sparse row table from a list of edges, where each
+     * row is indexed by a key computed by the function passed
+     *
+     * @param edges   The edges to store
+     * @param rows    The number of rows of the table
+     * @param key     A function that returns the row of an edge
+     * @param offsets The offsets of each row (rows+1 elements)
+     * @param targets The target states of each row
+     */
+    template <typename Key>
+    static void buildRows(const vector<Edge> &edges, size_t rows, Key key,
+                          vector<uint32_t> &offsets, vector<uint32_t> &targets);
+
+    vector<string> names; //!< The names of the states, indexed by ID
+    unordered_map<string, uint32_t> ids; //!< The interned names of the states
+    vector<char> symbols; //!< The symbols of the alphabet, indexed by column
+    vector<uint32_t> columns; //!< The column of each symbol (256 entries)
+    vector<bool> finals; //!< If each state is final, indexed by ID
+    uint32_t initial; //!< The ID of the initial state
+    vector<Edge> edges; //!< The transitions added since the last compile()
+    vector<uint32_t> offsets; //!< Row offsets, indexed by state*columns+column
+    vector<uint32_t> targets; //!< The target states of all the rows
+    vector<uint32_t> epsilon_offsets; //!< Row offsets of epsilon transitions
+    vector<uint32_t> epsilon_targets; //!< The targets of epsilon transitions
+    vector<uint32_t> reverse_offsets; //!< Reverse row offsets, indexed by state*columns+column
+    vector<uint32_t> reverse_sources; //!< The source states of all the reverse rows
+    vector<uint32_t> epsilon_reverse_offsets; //!< Reverse row offsets of epsilon transitions
+    vector<uint32_t> epsilon_reverse_sources; //!< The sources of epsilon transitions
+    uint32_t compiled_states; //!< Number of states in the last compile()
+    uint32_t compiled_columns; //!< Number of columns in the last compile()
+};
+#endif // COMPACT_AUTOMATA_H
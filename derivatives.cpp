@@ -0,0 +1,241 @@
+#include "derivatives.h"
+
+const uint32_t Derivatives::NOTHING = 0;
+
+const uint32_t Derivatives::EMPTY_WORD = 1;
+
+static uint64_t combine(uint64_t hash, uint64_t value) {
+    return hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+}
+
+Derivatives::Derivatives(Node *tree) {
+    vector<uint32_t> none;
+    intern(Expression{NONE, 0, 0, 0, 0, 0, false, 0}, none);
+    intern(Expression{EPSILON, 0, 0, 0, 0, 0, false, 0}, none);
+    FlatTree flat(tree);
+    if (flat.top() == FlatTree::NO_NODE) {
+        start = NOTHING;
+        return;
+    }
+    // The nodes are in post-order, so the expressions of the children of each
+    // node are on the top of the stack (a missing child is the empty word)
+    vector<uint32_t> stack;
+    for (uint32_t node = 0; node < flat.lambda(); node++) {
+        NodeType type = flat.type(node);
+        if (type == LEAF) {
+            alphabet.insert(flat.value(node));
+            stack.push_back(symbol(flat.value(node)));
+            continue;
+        }
+        uint32_t right = EMPTY_WORD;
+        if (flat.right(node) != FlatTree::NO_NODE) {
+            right = stack.back();
+            stack.pop_back();
+        }
+        uint32_t left = EMPTY_WORD;
+        if (flat.left(node) != FlatTree::NO_NODE) {
+            left = stack.back();
+            stack.pop_back();
+        }
+        switch (type) {
+            case DOT: stack.push_back(concatenate(left, right)); break;
+            case UNION: stack.push_back(alternate({left, right})); break;
+            case STAR: stack.push_back(repeat(left)); break;
+            case PLUS: stack.push_back(concatenate(left, repeat(left))); break;
+            case QUESTION: stack.push_back(alternate({EMPTY_WORD, left})); break;
+            default: stack.push_back(left);
+        }
+    }
+    start = stack.back();
+}
+
+uint32_t Derivatives::intern(Expression expression,
+                             const vector<uint32_t> &operands) {
+    uint64_t hash = combine(expression.kind, (unsigned char) expression.symbol);
+    hash = combine(hash, expression.left);
+    hash = combine(hash, expression.right);
+    for (uint32_t operand: operands) {
+        hash = combine(hash, operand);
+    }
+    auto range = table.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const Expression &other = expressions[it->second];
+        if (other.kind == expression.kind && other.symbol == expression.symbol &&
+                other.left == expression.left && other.right == expression.right &&
+                other.count == operands.size() &&
+                equal(operands.begin(), operands.end(), members.begin()+other.offset)) {
+            return it->second;
+        }
+    }
+    expression.hash = hash;
+    expression.offset = members.size();
+    expression.count = operands.size();
+    members.insert(members.end(), operands.begin(), operands.end());
+    switch (expression.kind) {
+        case EPSILON:
+        case REPETITION:
+            expression.nullable = true;
+            break;
+        case CONCATENATION:
+            expression.nullable = expressions[expression.left].nullable &&
+                expressions[expression.right].nullable;
+            break;
+        case ALTERNATION:
+            expression.nullable = false;
+            for (uint32_t operand: operands) {
+                expression.nullable |= expressions[operand].nullable;
+            }
+            break;
+        default:
+            expression.nullable = false;
+    }
+    uint32_t id = expressions.size();
+    expressions.push_back(expression);
+    table.insert(make_pair(hash, id));
+    return id;
+}
+
+uint32_t Derivatives::symbol(char symbol) {
+    return intern(Expression{SYMBOL, symbol, 0, 0, 0, 0, false, 0}, {});
+}
+
+uint32_t Derivatives::concatenate(uint32_t left, uint32_t right) {
+    if (left == NOTHING || right == NOTHING) {
+        return NOTHING;
+    }
+    if (left == EMPTY_WORD) {
+        return right;
+    }
+    if (right == EMPTY_WORD) {
+        return left;
+    }
+    // The first operand of a concatenation is never a concatenation
+    Expression first = expressions[left];
+    if (first.kind == CONCATENATION) {
+        return concatenate(first.left, concatenate(first.right, right));
+    }
+    return intern(Expression{CONCATENATION, 0, left, right, 0, 0, false, 0}, {});
+}
+
+uint32_t Derivatives::alternate(vector<uint32_t> operands) {
+    vector<uint32_t> flat;
+    for (uint32_t operand: operands) {
+        const Expression &expression = expressions[operand];
+        if (expression.kind == ALTERNATION) {
+            flat.insert(flat.end(), members.begin()+expression.offset,
+                        members.begin()+expression.offset+expression.count);
+        } else if (operand != NOTHING) {
+            flat.push_back(operand);
+        }
+    }
+    sort(flat.begin(), flat.end());
+    flat.erase(unique(flat.begin(), flat.end()), flat.end());
+    if (flat.empty()) {
+        return NOTHING;
+    }
+    if (flat.size() == 1) {
+        return flat[0];
+    }
+    return intern(Expression{ALTERNATION, 0, 0, 0, 0, 0, false, 0}, flat);
+}
+
+uint32_t Derivatives::repeat(uint32_t operand) {
+    if (operand == NOTHING || operand == EMPTY_WORD) {
+        return EMPTY_WORD;
+    }
+    if (expressions[operand].kind == REPETITION) {
+        return operand;
+    }
+    return intern(Expression{REPETITION, 0, operand, 0, 0, 0, false, 0}, {});
+}
+
+uint32_t Derivatives::root() const {
+    return start;
+}
+
+uint32_t Derivatives::size() const {
+    return expressions.size();
+}
+
+bool Derivatives::isNullable(uint32_t expression) const {
+    return expressions[expression].nullable;
+}
+
+uint32_t Derivatives::derive(uint32_t expression, char symbol) {
+    uint64_t key = (uint64_t) expression*256 + (unsigned char) symbol;
+    auto it = derivatives.find(key);
+    if (it != derivatives.end()) {
+        return it->second;
+    }
+    // The expressions may move while deriving, so work on a copy
+    Expression e = expressions[expression];
+    uint32_t result = NOTHING;
+    switch (e.kind) {
+        case SYMBOL:
+            result = e.symbol == symbol ? EMPTY_WORD : NOTHING;
+            break;
+        case CONCATENATION:
+            result = concatenate(derive(e.left, symbol), e.right);
+            if (expressions[e.left].nullable) {
+                result = alternate({result, derive(e.right, symbol)});
+            }
+            break;
+        case ALTERNATION: {
+            vector<uint32_t> operands(members.begin()+e.offset,
+                                      members.begin()+e.offset+e.count);
+            for (uint32_t &operand: operands) {
+                operand = derive(operand, symbol);
+            }
+            result = alternate(operands);
+            break;
+        }
+        case REPETITION:
+            result = concatenate(derive(e.left, symbol), expression);
+            break;
+        default:
+            break;
+    }
+    derivatives[key] = result;
+    return result;
+}
+
+bool Derivatives::accepts(const string &word) {
+    uint32_t expression = start;
+    for (char symbol: word) {
+        expression = derive(expression, symbol);
+        if (expression == NOTHING) {
+            return false;
+        }
+    }
+    return isNullable(expression);
+}
+
+CompactAutomata Derivatives::getAutomata() {
+    CompactAutomata dfa;
+    vector<char> symbols(alphabet.begin(), alphabet.end());
+    for (char symbol: symbols) {
+        dfa.addSymbol(symbol);
+    }
+    vector<uint32_t> order;
+    unordered_map<uint32_t, uint32_t> states;
+    order.push_back(start);
+    states[start] = 0;
+    dfa.setInitialState(dfa.addState("", isNullable(start)));
+    for (uint32_t state = 0; state < order.size(); state++) {
+        for (uint32_t column = 0; column < symbols.size(); column++) {
+            uint32_t target = derive(order[state], symbols[column]);
+            if (target == NOTHING) {
+                continue;
+            }
+            auto it = states.find(target);
+            if (it == states.end()) {
+                it = states.insert(make_pair(target, (uint32_t) order.size())).first;
+                order.push_back(target);
+                dfa.addState("", isNullable(target));
+            }
+            dfa.addTransition(state, column, it->second);
+        }
+    }
+    dfa.compile();
+    return dfa;
+}
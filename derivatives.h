@@ -0,0 +1,163 @@
+#ifndef DERIVATIVES_H
+#define DERIVATIVES_H
+
+#include "all.h"
+#include "node.h"
+#include "flat_tree.h"
+#include "compact_automata.h"
+
+/*!
+ * This class computes the derivatives of Brzozowski of a regular expression:
+ * the derivative of an expression by a symbol accepts the words w such that
+ * the expression accepts the symbol followed by w. A word is accepted when
+ * the derivative by all its symbols accepts the empty word.
+ *
+ * The expressions are hash-consed (each distinct expression is stored once
+ * and identified by an ID, so comparing expressions compares IDs) and kept
+ * in a normal form: unions are flattened, sorted and without repetitions or
+ * empty languages (associativity, commutativity and idempotence),
+ * concatenations are nested to the right and drop the empty word, and stars
+ * are not nested. With that normal form an expression has a finite number of
+ * distinct derivatives, which are the states of its deterministic automata.
+ *
+ * The derivatives are memoized, so matching a word only computes the
+ * derivatives that it reaches, once.
+ */
+class Derivatives {
+public:
+    /*!
+     * Constructs the expression of a De Simone tree
+     *
+     * @param tree The tree (or the lambda node alone for the empty language)
+     */
+    explicit Derivatives(Node *tree);
+
+    /*!
+     * Return the ID of the expression of the tree
+     *
+     * @return The ID of the expression
+     */
+    uint32_t root() const;
+
+    /*!
+     * Return the number of distinct expressions built so far
+     *
+     * @return The number of expressions
+     */
+    uint32_t size() const;
+
+    /*!
+     * Check if an expression accepts the empty word
+     *
+     * @param expression The ID of the expression
+     * @return true if the expression accepts the empty word, false otherwise
+     */
+    bool isNullable(uint32_t expression) const;
+
+    /*!
+     * Return the derivative of an expression by a symbol
+     *
+     * @param expression The ID of the expression
+     * @param symbol     The symbol
+     * @return The ID of the derivative
+     */
+    uint32_t derive(uint32_t expression, char symbol);
+
+    /*!
+     * Check if a word is accepted by the expression, without building any
+     * automata
+     *
+     * @param word The word to check
+     * @return true if the word is accepted, false otherwise
+     */
+    bool accepts(const string &word);
+
+    /*!
+     * Build the deterministic automata whose states are the derivatives of
+     * the expression, numbered in the order they are reached. The
+     * derivatives that accept nothing are left out, so the automata may be
+     * incomplete.
+     *
+     * @return The deterministic automata
+     */
+    CompactAutomata getAutomata();
+
+    const static uint32_t NOTHING; //!< The ID of the empty language
+    const static uint32_t EMPTY_WORD; //!< The ID of the empty word
+private:
+    /*!
+     * The kinds of expressions
+     */
+    enum Kind {
+        NONE, //!< The empty language
+        EPSILON, //!< The empty word
+        SYMBOL, //!< A symbol
+        CONCATENATION, //!< A concatenation of two expressions
+        ALTERNATION, //!< A union of two or more expressions
+        REPETITION //!< A star of an expression
+    };
+
+    /*!
+     * An expression
+     */
+    struct Expression {
+        Kind kind; //!< The kind of the expression
+        char symbol; //!< The symbol of a SYMBOL
+        uint32_t left; //!< The first operand
+        uint32_t right; //!< The second operand of a CONCATENATION
+        uint32_t offset; //!< The offset of the operands of an ALTERNATION
+        uint32_t count; //!< The number of operands of an ALTERNATION
+        bool nullable; //!< If the empty word is accepted
+        uint64_t hash; //!< The hash of the expression
+    };
+
+    /*!
+     * Return the ID of an expression, adding it if it was not built yet
+     *
+     * @param expression The expression (without the hash)
+     * @param operands   The operands of an ALTERNATION
+     * @return The ID of the expression
+     */
+    uint32_t intern(Expression expression, const vector<uint32_t> &operands);
+
+    /*!
+     * Build a symbol
+     *
+     * @param symbol The symbol
+     * @return The ID of the expression
+     */
+    uint32_t symbol(char symbol);
+
+    /*!
+     * Build the concatenation of two expressions, in normal form
+     *
+     * @param left  The first expression
+     * @param right The second expression
+     * @return The ID of the expression
+     */
+    uint32_t concatenate(uint32_t left, uint32_t right);
+
+    /*!
+     * Build the union of some expressions, in normal form
+     *
+     * @param operands The expressions
+     * @return The ID of the expression
+     */
+    uint32_t alternate(vector<uint32_t> operands);
+
+    /*!
+     * Build the star of an expression, in normal form
+     *
+     * @param operand The expression
+     * @return The ID of the expression
+     */
+    uint32_t repeat(uint32_t operand);
+
+    vector<Expression> expressions; //!< The expressions, indexed by ID
+    vector<uint32_t> members; //!< The operands of the unions
+    unordered_multimap<uint64_t, uint32_t> table; //!< The IDs of the expressions, by hash
+    unordered_map<uint64_t, uint32_t> derivatives; //!< The derivatives, by expression*256+symbol
+    set<char> alphabet; //!< The symbols of the expression
+    uint32_t start; //!< The ID of the expression of the tree
+};
+#endif // DERIVATIVES_H
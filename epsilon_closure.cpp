@@ -0,0 +1,123 @@
+#include "epsilon_closure.h"
+
+EpsilonClosure::EpsilonClosure(const CompactAutomata &nfa) {
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    uint32_t n = nfa.size();
+    components.assign(n, NONE);
+    offsets.assign(1, 0);
+    // Iterative Tarjan: the call stack keeps each state with the position of
+    // the next epsilon transition to visit
+    vector<uint32_t> index(n, NONE), lowlink(n, 0), stack;
+    vector<pair<uint32_t, uint32_t> > calls;
+    vector<uint32_t> marks(n, NONE), closure;
+    uint32_t counter = 0;
+    for (uint32_t root = 0; root < n; root++) {
+        if (index[root] != NONE) {
+            continue;
+        }
+        calls.push_back(make_pair(root, 0));
+        while (!calls.empty()) {
+            uint32_t state = calls.back().first;
+            if (calls.back().second == 0 && index[state] == NONE) {
+                index[state] = lowlink[state] = counter++;
+                stack.push_back(state);
+            }
+            StateRange targets = nfa.epsilonSuccessors(state);
+            if (calls.back().second < targets.size()) {
+                uint32_t target = targets.begin()[calls.back().second++];
+                if (index[target] == NONE) {
+                    calls.push_back(make_pair(target, 0));
+                } else if (components[target] == NONE) {
+                    lowlink[state] = min(lowlink[state], index[target]);
+                }
+                continue;
+            }
+            calls.pop_back();
+            if (!calls.empty()) {
+                uint32_t parent = calls.back().first;
+                lowlink[parent] = min(lowlink[parent], lowlink[state]);
+            }
+            if (lowlink[state] != index[state]) {
+                continue;
+            }
+            // The state is the root of a component: its members are on the
+            // top of the stack, and the components that they reach are done
+            uint32_t number = offsets.size()-1;
+            size_t first = stack.size();
+            do {
+                first--;
+                components[stack[first]] = number;
+            } while (stack[first] != state);
+            closure.clear();
+            for (size_t i = first; i < stack.size(); i++) {
+                uint32_t member = stack[i];
+                if (marks[member] != number) {
+                    marks[member] = number;
+                    closure.push_back(member);
+                }
+                for (uint32_t target: nfa.epsilonSuccessors(member)) {
+                    uint32_t other = components[target];
+                    if (other == number) {
+                        continue;
+                    }
+                    for (uint32_t j = offsets[other]; j < offsets[other+1]; j++) {
+                        if (marks[states[j]] != number) {
+                            marks[states[j]] = number;
+                            closure.push_back(states[j]);
+                        }
+                    }
+                }
+            }
+            stack.resize(first);
+            sort(closure.begin(), closure.end());
+            states.insert(states.end(), closure.begin(), closure.end());
+            offsets.push_back(states.size());
+        }
+    }
+}
+
+StateRange EpsilonClosure::closure(uint32_t state) const {
+    uint32_t c = components[state];
+    const uint32_t *base = states.data();
+    return StateRange(base+offsets[c], base+offsets[c+1]);
+}
+
+uint32_t EpsilonClosure::component(uint32_t state) const {
+    return components[state];
+}
+
+uint32_t EpsilonClosure::componentCount() const {
+    return offsets.size()-1;
+}
+
+uint32_t EpsilonClosure::size() const {
+    return components.size();
+}
+
+CompactAutomata EpsilonClosure::removeEpsilonTransitions(const CompactAutomata &nfa) const {
+    CompactAutomata result;
+    for (uint32_t column = 0; column < nfa.symbolCount(); column++) {
+        result.addSymbol(nfa.symbolAt(column));
+    }
+    for (uint32_t state = 0; state < nfa.size(); state++) {
+        bool final = false;
+        for (uint32_t reached: closure(state)) {
+            final = final || nfa.isFinalState(reached);
+        }
+        result.addState(nfa.stateName(state), final);
+    }
+    if (nfa.initialState() != CompactAutomata::NO_STATE) {
+        result.setInitialState(nfa.initialState());
+    }
+    for (uint32_t state = 0; state < nfa.size(); state++) {
+        for (uint32_t reached: closure(state)) {
+            for (uint32_t column = 0; column < nfa.symbolCount(); column++) {
+                for (uint32_t target: nfa.successors(reached, column)) {
+                    result.addTransition(state, column, target);
+                }
+            }
+        }
+    }
+    result.compile();
+    return result;
+}
@@ -0,0 +1,79 @@
+#ifndef EPSILON_CLOSURE_H
+#define EPSILON_CLOSURE_H
+
+#include "all.h"
+#include "compact_automata.h"
+
+/*!
+ * This class holds the epsilon closures of all the states of an automata,
+ * computed once.
+ *
+ * The states connected by cycles of epsilon transitions have the same
+ * closure, so the strongly connected components of the epsilon transitions
+ * are found first (with the algorithm of Tarjan) and each closure is stored
+ * once per component. As the algorithm of Tarjan finishes a component only
+ * after all the components reachable from it, the closure of a component is
+ * built from the closures already computed, without any new search.
+ *
+ * The closures only depend on the IDs of the states and on the epsilon
+ * transitions, so they stay valid while only the transitions by symbols or
+ * the final states change.
+ */
+class EpsilonClosure {
+public:
+    /*!
+     * Compute the epsilon closures of the states of a compiled automata
+     *
+     * @param nfa The automata
+     */
+    explicit EpsilonClosure(const CompactAutomata &nfa);
+
+    /*!
+     * Return the epsilon closure of a state (including the state itself)
+     *
+     * @param state The ID of the state
+     * @return The range of states in the closure, ordered by ID
+     */
+    StateRange closure(uint32_t state) const;
+
+    /*!
+     * Return the strongly connected component of epsilon transitions of a
+     * state. The components are numbered in reverse topological order, so a
+     * component only reaches components with smaller numbers.
+     *
+     * @param state The ID of the state
+     * @return The number of the component
+     */
+    uint32_t component(uint32_t state) const;
+
+    /*!
+     * Return the number of strongly connected components
+     *
+     * @return The number of components
+     */
+    uint32_t componentCount() const;
+
+    /*!
+     * Return the number of states of the automata of these closures
+     *
+     * @return The number of states
+     */
+    uint32_t size() const;
+
+    /*!
+     * Return an automata equivalent to an automata (the same used to compute
+     * these closures) without epsilon transitions, where each state has the
+     * transitions of its closure and is final if its closure has a final
+     * state. The IDs and the names of the states are the same.
+     *
+     * @param nfa The automata used to compute these closures
+     * @return The automata without epsilon transitions
+     */
+    CompactAutomata removeEpsilonTransitions(const CompactAutomata &nfa) const;
+
+private:
+    vector<uint32_t> components; //!< The component of each state
+    vector<uint32_t> offsets; //!< Offsets of the closures, indexed by component
+    vector<uint32_t> states; //!< The states of all the closures
+};
+#endif // EPSILON_CLOSURE_H
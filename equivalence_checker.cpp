@@ -0,0 +1,259 @@
+#include "equivalence_checker.h"
+
+EquivalenceChecker::EquivalenceChecker(const CompactAutomata &left,
+                                       const CompactAutomata &right,
+                                       shared_ptr<const EpsilonClosure> left_closure,
+                                       shared_ptr<const EpsilonClosure> right_closure):
+    left(left), right(right), left_closure(left_closure),
+    right_closure(right_closure), final_states(left.size()+right.size()) {
+    if (!this->left_closure) {
+        this->left_closure = make_shared<EpsilonClosure>(left);
+    }
+    if (!this->right_closure) {
+        this->right_closure = make_shared<EpsilonClosure>(right);
+    }
+    set<char> alphabet;
+    for (uint32_t column = 0; column < left.symbolCount(); column++) {
+        alphabet.insert(left.symbolAt(column));
+    }
+    for (uint32_t column = 0; column < right.symbolCount(); column++) {
+        alphabet.insert(right.symbolAt(column));
+    }
+    for (char symbol: alphabet) {
+        symbols.push_back(symbol);
+        left_columns.push_back(left.symbolColumn(symbol));
+        right_columns.push_back(right.symbolColumn(symbol));
+    }
+    for (uint32_t state = 0; state < left.size(); state++) {
+        if (left.isFinalState(state)) {
+            final_states.insert(state);
+        }
+    }
+    for (uint32_t state = 0; state < right.size(); state++) {
+        if (right.isFinalState(state)) {
+            final_states.insert(left.size()+state);
+        }
+    }
+}
+
+bool EquivalenceChecker::isDeterministic() const {
+    return left.isDeterministic() && right.isDeterministic();
+}
+
+uint32_t EquivalenceChecker::successor(uint32_t state, uint32_t symbol) const {
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    uint32_t error = left.size()+right.size();
+    uint32_t target = NONE;
+    if (state < left.size()) {
+        if (left_columns[symbol] != NONE) {
+            target = left.successor(state, left_columns[symbol]);
+        }
+    } else if (state < error && right_columns[symbol] != NONE) {
+        target = right.successor(state-left.size(), right_columns[symbol]);
+        if (target != NONE) {
+            target += left.size();
+        }
+    }
+    return target == NONE ? error : target;
+}
+
+bool EquivalenceChecker::isFinal(uint32_t state) const {
+    return state < final_states.capacity() && final_states.contains(state);
+}
+
+void EquivalenceChecker::closure(StateSet &states) const {
+    for (uint32_t state: states.elements()) {
+        if (state < left.size()) {
+            for (uint32_t reached: left_closure->closure(state)) {
+                states.insert(reached);
+            }
+        } else {
+            for (uint32_t reached: right_closure->closure(state-left.size())) {
+                states.insert(left.size()+reached);
+            }
+        }
+    }
+}
+
+StateSet EquivalenceChecker::step(const StateSet &states, uint32_t symbol) const {
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    StateSet result(states.capacity());
+    states.forEach([&](uint32_t state) {
+        if (state < left.size()) {
+            if (left_columns[symbol] != NONE) {
+                for (uint32_t target: left.successors(state, left_columns[symbol])) {
+                    result.insert(target);
+                }
+            }
+        } else if (right_columns[symbol] != NONE) {
+            uint32_t column = right_columns[symbol];
+            for (uint32_t target: right.successors(state-left.size(), column)) {
+                result.insert(left.size()+target);
+            }
+        }
+    });
+    closure(result);
+    return result;
+}
+
+StateSet EquivalenceChecker::initialStates(bool right) const {
+    StateSet result(left.size()+this->right.size());
+    if (right && this->right.initialState() != CompactAutomata::NO_STATE) {
+        result.insert(left.size()+this->right.initialState());
+    } else if (!right && left.initialState() != CompactAutomata::NO_STATE) {
+        result.insert(left.initialState());
+    }
+    closure(result);
+    return result;
+}
+
+StateSet EquivalenceChecker::saturate(const StateSet &states,
+                                      const vector<pair<StateSet, StateSet> > &pairs,
+                                      const vector<uint32_t> &relation) {
+    StateSet result = states;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t index: relation) {
+            const StateSet &first = pairs[index].first;
+            const StateSet &second = pairs[index].second;
+            if (first.isSubsetOf(result)) {
+                changed |= result.unite(second);
+            }
+            if (second.isSubsetOf(result)) {
+                changed |= result.unite(first);
+            }
+        }
+    }
+    return result;
+}
+
+string EquivalenceChecker::path(const vector<Visit> &visits, uint32_t index) const {
+    string word;
+    for (; visits[index].parent != CompactAutomata::NO_STATE;
+         index = visits[index].parent) {
+        word.push_back(symbols[visits[index].symbol]);
+    }
+    reverse(word.begin(), word.end());
+    return word;
+}
+
+bool EquivalenceChecker::unionFind(uint32_t first, uint32_t second,
+                                   string &counterexample) const {
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    // The error state is the last state of the disjoint union
+    uint32_t n = left.size()+right.size()+1;
+    vector<uint32_t> parents(n), sizes(n, 1);
+    for (uint32_t state = 0; state < n; state++) {
+        parents[state] = state;
+    }
+    auto find = [&](uint32_t state) {
+        while (parents[state] != state) {
+            parents[state] = parents[parents[state]];
+            state = parents[state];
+        }
+        return state;
+    };
+    vector<pair<uint32_t, uint32_t> > pairs(1, make_pair(first, second));
+    vector<Visit> visits(1, Visit{NONE, NONE});
+    for (uint32_t index = 0; index < pairs.size(); index++) {
+        uint32_t p = find(pairs[index].first), q = find(pairs[index].second);
+        if (p == q) {
+            continue;
+        }
+        if (isFinal(pairs[index].first) != isFinal(pairs[index].second)) {
+            counterexample = path(visits, index);
+            return false;
+        }
+        if (sizes[p] < sizes[q]) {
+            swap(p, q);
+        }
+        parents[q] = p;
+        sizes[p] += sizes[q];
+        for (uint32_t symbol = 0; symbol < symbols.size(); symbol++) {
+            pairs.push_back(make_pair(successor(pairs[index].first, symbol),
+                                      successor(pairs[index].second, symbol)));
+            visits.push_back(Visit{index, symbol});
+        }
+    }
+    return true;
+}
+
+bool EquivalenceChecker::congruence(const StateSet &first, const StateSet &second,
+                                    string &counterexample) const {
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    vector<pair<StateSet, StateSet> > pairs(1, make_pair(first, second));
+    vector<Visit> visits(1, Visit{NONE, NONE});
+    vector<uint32_t> relation;
+    for (uint32_t index = 0; index < pairs.size(); index++) {
+        const StateSet &x = pairs[index].first;
+        const StateSet &y = pairs[index].second;
+        // Skip the pairs that are in the congruence closure of the relation
+        if (y.isSubsetOf(saturate(x, pairs, relation)) &&
+            x.isSubsetOf(saturate(y, pairs, relation))) {
+            continue;
+        }
+        if (x.intersects(final_states) != y.intersects(final_states)) {
+            counterexample = path(visits, index);
+            return false;
+        }
+        relation.push_back(index);
+        for (uint32_t symbol = 0; symbol < symbols.size(); symbol++) {
+            StateSet nextX = step(pairs[index].first, symbol);
+            StateSet nextY = step(pairs[index].second, symbol);
+            pairs.push_back(make_pair(nextX, nextY));
+            visits.push_back(Visit{index, symbol});
+        }
+    }
+    return true;
+}
+
+bool EquivalenceChecker::isEquivalent(string &counterexample) const {
+    if (isDeterministic()) {
+        uint32_t error = left.size()+right.size();
+        uint32_t p = left.initialState(), q = right.initialState();
+        p = p == CompactAutomata::NO_STATE ? error : p;
+        q = q == CompactAutomata::NO_STATE ? error : left.size()+q;
+        return unionFind(p, q, counterexample);
+    }
+    return congruence(initialStates(false), initialStates(true), counterexample);
+}
+
+bool EquivalenceChecker::isContained(string &counterexample) const {
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    if (!isDeterministic()) {
+        AntichainInclusion inclusion(left, right, left_closure, right_closure);
+        return inclusion.isContained(counterexample);
+    }
+    // The reachable pairs of states are explored until a pair where only the
+    // left state is final is found
+    uint32_t error = left.size()+right.size();
+    uint32_t p = left.initialState(), q = right.initialState();
+    p = p == NONE ? error : p;
+    q = q == NONE ? error : left.size()+q;
+    vector<pair<uint32_t, uint32_t> > pairs(1, make_pair(p, q));
+    vector<Visit> visits(1, Visit{NONE, NONE});
+    unordered_set<uint64_t> visited;
+    visited.insert(((uint64_t) p << 32) | q);
+    for (uint32_t index = 0; index < pairs.size(); index++) {
+        p = pairs[index].first;
+        q = pairs[index].second;
+        if (isFinal(p) && !isFinal(q)) {
+            counterexample = path(visits, index);
+            return false;
+        }
+        for (uint32_t symbol = 0; symbol < symbols.size(); symbol++) {
+            uint32_t nextP = successor(p, symbol);
+            // Nothing is accepted from the error state of the left automata
+            if (nextP == error) {
+                continue;
+            }
+            uint32_t nextQ = successor(q, symbol);
+            if (visited.insert(((uint64_t) nextP << 32) | nextQ).second) {
+                pairs.push_back(make_pair(nextP, nextQ));
+                visits.push_back(Visit{index, symbol});
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,176 @@
+#ifndef EQUIVALENCE_CHECKER_H
+#define EQUIVALENCE_CHECKER_H
+
+#include "all.h"
+#include "compact_automata.h"
+#include "state_set.h"
+#include "epsilon_closure.h"
+#include "antichain_inclusion.h"
+
+/*!
+ * This class checks the equivalence and the inclusion of the languages of two
+ * automata on the fly, without building any intermediate automata, stopping
+ * at the first word that distinguishes them (the counterexample).
+ *
+ * When both automata are deterministic, the equivalence is checked with the
+ * union-find algorithm of Hopcroft and Karp, and the inclusion by exploring
+ * the reachable pairs of states. Otherwise, the equivalence runs over pairs of
+ * sets of states, pruning the pairs that are already implied by the visited
+ * ones (bisimulation up to congruence, from Bonchi and Pous), and the
+ * inclusion is checked by AntichainInclusion.
+ *
+ * Missing transitions go to an implicit error state, and the symbols of the
+ * alphabet of only one of the automata are valid in both of them.
+ */
+class EquivalenceChecker {
+public:
+    /*!
+     * Constructs a checker between two compiled automata
+     *
+     * @param left          The automata on the left side of the check
+     * @param right         The automata on the right side of the check
+     * @param left_closure  The epsilon closures of the left automata, which
+     *                      are computed if they are not passed
+     * @param right_closure The epsilon closures of the right automata, which
+     *                      are computed if they are not passed
+     */
+    EquivalenceChecker(const CompactAutomata &left, const CompactAutomata &right,
+                       shared_ptr<const EpsilonClosure> left_closure = nullptr,
+                       shared_ptr<const EpsilonClosure> right_closure = nullptr);
+
+    /*!
+     * Check if the automata accept the same language
+     *
+     * @param counterexample Receives a word accepted by only one of the
+     *                       automata, when they are not equivalent
+     * @return true if the automata are equivalent, false otherwise
+     */
+    bool isEquivalent(string &counterexample) const;
+
+    /*!
+     * Check if the language of the left automata is contained in the language
+     * of the right automata
+     *
+     * @param counterexample Receives a word accepted by the left automata but
+     *                       not by the right automata, when there is one
+     * @return true if the language is contained, false otherwise
+     */
+    bool isContained(string &counterexample) const;
+
+protected:
+    /*!
+     * A pair being explored, with the pair that discovered it, so the path
+     * from the initial pair can be rebuilt
+     */
+    struct Visit {
+        uint32_t parent; //!< The index of the parent visit (or NO_STATE)
+        uint32_t symbol; //!< The index of the symbol read from the parent
+    };
+
+    /*!
+     * Check if both automata are deterministic
+     *
+     * @return true if both automata are deterministic, false otherwise
+     */
+    bool isDeterministic() const;
+
+    /*!
+     * Return the target of a transition in the disjoint union of the
+     * deterministic automata, where the error state has the ID left.size() +
+     * right.size()
+     *
+     * @param state  The source state
+     * @param symbol The index of the symbol
+     * @return The target state
+     */
+    uint32_t successor(uint32_t state, uint32_t symbol) const;
+
+    /*!
+     * Check if a state of the disjoint union is final
+     *
+     * @param state The state
+     * @return true if the state is final, false otherwise
+     */
+    bool isFinal(uint32_t state) const;
+
+    /*!
+     * Add to a set of states of the disjoint union the states reachable by
+     * epsilon transitions
+     *
+     * @param states The set of states to expand
+     */
+    void closure(StateSet &states) const;
+
+    /*!
+     * Return the set of the states reachable from a set of states of the
+     * disjoint union by a symbol (including the epsilon closure)
+     *
+     * @param states The source states
+     * @param symbol The index of the symbol
+     * @return The set of target states
+     */
+    StateSet step(const StateSet &states, uint32_t symbol) const;
+
+    /*!
+     * Return the initial states of the disjoint union of one of the automata
+     *
+     * @param right true for the right automata, false for the left automata
+     * @return The set of initial states
+     */
+    StateSet initialStates(bool right) const;
+
+    /*!
+     * Saturate a set of states with the pairs of a relation, adding the other
+     * side of each pair where one side is already contained in the set
+     *
+     * @param states   The set of states to saturate
+     * @param pairs    The pairs of sets of states
+     * @param relation The indexes of the pairs in the relation
+     * @return The saturated set
+     */
+    static StateSet saturate(const StateSet &states,
+                             const vector<pair<StateSet, StateSet> > &pairs,
+                             const vector<uint32_t> &relation);
+
+    /*!
+     * Check if two states of the disjoint union of the deterministic automata
+     * are equivalent with the Hopcroft and Karp algorithm
+     *
+     * @param first          The first state
+     * @param second         The second state
+     * @param counterexample Receives a word that distinguishes them
+     * @return true if the states are equivalent, false otherwise
+     */
+    bool unionFind(uint32_t first, uint32_t second, string &counterexample) const;
+
+    /*!
+     * Check if two sets of states are equivalent with the bisimulation up to
+     * congruence
+     *
+     * @param first          The first set of states
+     * @param second         The second set of states
+     * @param counterexample Receives a word that distinguishes them
+     * @return true if the sets are equivalent, false otherwise
+     */
+    bool congruence(const StateSet &first, const StateSet &second,
+                    string &counterexample) const;
+
+    /*!
+     * Rebuild the word that leads from the initial pair to a visit
+     *
+     * @param visits The visits
+     * @param index  The index of the visit
+     * @return The word
+     */
+    string path(const vector<Visit> &visits, uint32_t index) const;
+
+    const CompactAutomata &left; //!< The automata on the left side
+    const CompactAutomata &right; //!< The automata on the right side
+    shared_ptr<const EpsilonClosure> left_closure; //!< The epsilon closures of the left automata
+    shared_ptr<const EpsilonClosure> right_closure; //!< The epsilon closures of the right automata
+    vector<char> symbols; //!< The union of the alphabets
+    vector<uint32_t> left_columns; //!< The column of each symbol on the left
+    vector<uint32_t> right_columns; //!< The column of each symbol on the right
+    StateSet final_states; //!< The final states of the disjoint union
+};
+#endif // EQUIVALENCE_CHECKER_H
@@ -0,0 +1,183 @@
+#include "expression_dag.h"
+
+const uint32_t ExpressionDag::NO_NODE = UINT32_MAX;
+
+ExpressionDag::ExpressionDag(Node *tree): top(NO_NODE) {
+    FlatTree flat(tree);
+    if (flat.top() == FlatTree::NO_NODE) {
+        return;
+    }
+    // The nodes are in post-order, so the shared nodes of the children of
+    // each node are on the top of the stack
+    vector<uint32_t> stack;
+    for (uint32_t node = 0; node < flat.lambda(); node++) {
+        uint32_t right = NO_NODE;
+        if (flat.right(node) != FlatTree::NO_NODE) {
+            right = stack.back();
+            stack.pop_back();
+        }
+        uint32_t left = NO_NODE;
+        if (flat.left(node) != FlatTree::NO_NODE) {
+            left = stack.back();
+            stack.pop_back();
+        }
+        stack.push_back(intern(flat.type(node), flat.value(node), left, right));
+    }
+    top = stack.back();
+}
+
+void ExpressionDag::append(vector<uint32_t> &positions,
+                           const vector<uint32_t> &other, uint32_t offset) {
+    for (uint32_t position: other) {
+        positions.push_back(position+offset);
+    }
+}
+
+uint32_t ExpressionDag::intern(NodeType type, char value, uint32_t left,
+                               uint32_t right) {
+    auto key = make_pair(((uint64_t) left << 32) | right,
+                         ((uint32_t) type << 8) | (unsigned char) value);
+    auto it = ids.find(key);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    Shared node{type, value, left, right, 0, false, {}, {}};
+    uint32_t size = leafCount(left);
+    switch (type) {
+        case LEAF:
+            node.leaves = 1;
+            node.first.push_back(0);
+            node.last.push_back(0);
+            break;
+        case DOT:
+            node.leaves = size+leafCount(right);
+            node.nullable = isNullable(left) && isNullable(right);
+            node.first = first(left);
+            if (isNullable(left)) {
+                append(node.first, first(right), size);
+            }
+            if (isNullable(right)) {
+                node.last = last(left);
+            }
+            append(node.last, last(right), size);
+            break;
+        case UNION:
+            node.leaves = size+leafCount(right);
+            node.nullable = isNullable(left) || isNullable(right);
+            node.first = first(left);
+            append(node.first, first(right), size);
+            node.last = last(left);
+            append(node.last, last(right), size);
+            break;
+        default:
+            node.leaves = size;
+            node.nullable = type != PLUS || isNullable(left);
+            node.first = first(left);
+            node.last = last(left);
+    }
+    uint32_t id = nodes.size();
+    nodes.push_back(move(node));
+    ids[key] = id;
+    return id;
+}
+
+uint32_t ExpressionDag::root() const {
+    return top;
+}
+
+uint32_t ExpressionDag::size() const {
+    return nodes.size();
+}
+
+NodeType ExpressionDag::type(uint32_t node) const {
+    return nodes[node].type;
+}
+
+char ExpressionDag::value(uint32_t node) const {
+    return nodes[node].value;
+}
+
+uint32_t ExpressionDag::left(uint32_t node) const {
+    return nodes[node].left;
+}
+
+uint32_t ExpressionDag::right(uint32_t node) const {
+    return nodes[node].right;
+}
+
+uint32_t ExpressionDag::leafCount(uint32_t node) const {
+    return node == NO_NODE ? 0 : nodes[node].leaves;
+}
+
+bool ExpressionDag::isNullable(uint32_t node) const {
+    return node == NO_NODE || nodes[node].nullable;
+}
+
+const vector<uint32_t> &ExpressionDag::first(uint32_t node) const {
+    return node == NO_NODE ? none : nodes[node].first;
+}
+
+const vector<uint32_t> &ExpressionDag::last(uint32_t node) const {
+    return node == NO_NODE ? none : nodes[node].last;
+}
+
+GlushkovPositions ExpressionDag::positions() const {
+    GlushkovPositions positions;
+    positions.nullable = false;
+    if (top == NO_NODE) {
+        return positions;
+    }
+    uint32_t count = leafCount(top);
+    positions.symbols.resize(count);
+    positions.follow.assign(count, vector<uint32_t>());
+    positions.first = StateSet(count);
+    positions.last = StateSet(count);
+    for (uint32_t position: first(top)) {
+        positions.first.insert(position);
+    }
+    for (uint32_t position: last(top)) {
+        positions.last.insert(position);
+    }
+    positions.nullable = isNullable(top);
+
+    // Each occurrence of a shared node, with the position of its first leaf
+    vector<pair<uint32_t, uint32_t>> pending(1, make_pair(top, 0));
+    while (!pending.empty()) {
+        uint32_t node = pending.back().first;
+        uint32_t offset = pending.back().second;
+        pending.pop_back();
+        if (node == NO_NODE) {
+            continue;
+        }
+        const Shared &shared = nodes[node];
+        if (shared.type == LEAF) {
+            positions.symbols[offset] = shared.value;
+            continue;
+        }
+        uint32_t size = leafCount(shared.left);
+        if (shared.type == DOT) {
+            for (uint32_t from: last(shared.left)) {
+                for (uint32_t to: first(shared.right)) {
+                    positions.follow[offset+from].push_back(offset+size+to);
+                }
+            }
+        } else if (shared.type == STAR || shared.type == PLUS) {
+            for (uint32_t from: shared.last) {
+                for (uint32_t to: shared.first) {
+                    positions.follow[offset+from].push_back(offset+to);
+                }
+            }
+        }
+        pending.push_back(make_pair(shared.left, offset));
+        if (shared.type == DOT || shared.type == UNION) {
+            pending.push_back(make_pair(shared.right, offset+size));
+        }
+    }
+    // A pair may be added by more than one occurrence (like the ones of a
+    // star inside another)
+    for (vector<uint32_t> &follow: positions.follow) {
+        sort(follow.begin(), follow.end());
+        follow.erase(unique(follow.begin(), follow.end()), follow.end());
+    }
+    return positions;
+}
@@ -0,0 +1,163 @@
+#ifndef EXPRESSION_DAG_H
+#define EXPRESSION_DAG_H
+
+#include "all.h"
+#include "node.h"
+#include "flat_tree.h"
+#include "glushkov_matcher.h"
+
+/*!
+ * A De Simone tree with its equal subtrees shared: each distinct
+ * subexpression is stored once (it is hash-consed by its type, value and
+ * children), so a fragment repeated many times in a regular expression is a
+ * single node of this DAG.
+ *
+ * What depends only on the subexpression is computed once per shared node,
+ * when it is added: the number of leaves, if the empty word is accepted, and
+ * the first and last positions, relative to the first leaf of the
+ * subexpression. Each occurrence of the subexpression reads them shifted by
+ * the position of its first leaf.
+ */
+class ExpressionDag {
+public:
+    /*!
+     * Constructs the DAG of a tree
+     *
+     * @param tree The tree (or the lambda node alone for the empty language)
+     */
+    explicit ExpressionDag(Node *tree);
+
+    /*!
+     * Return the node of the whole expression
+     *
+     * @return The node of the whole expression, or NO_NODE if it is empty
+     */
+    uint32_t root() const;
+
+    /*!
+     * Return the number of shared nodes
+     *
+     * @return The number of shared nodes
+     */
+    uint32_t size() const;
+
+    /*!
+     * Return the type of a node
+     *
+     * @param node The node
+     * @return The type of the node
+     */
+    NodeType type(uint32_t node) const;
+
+    /*!
+     * Return the value of a node
+     *
+     * @param node The node
+     * @return The value of the node
+     */
+    char value(uint32_t node) const;
+
+    /*!
+     * Return the left child of a node
+     *
+     * @param node The node
+     * @return The left child, or NO_NODE
+     */
+    uint32_t left(uint32_t node) const;
+
+    /*!
+     * Return the right child of a node
+     *
+     * @param node The node
+     * @return The right child, or NO_NODE
+     */
+    uint32_t right(uint32_t node) const;
+
+    /*!
+     * Return the number of leaves of a node (counting each occurrence of its
+     * shared children)
+     *
+     * @param node The node, or NO_NODE for the empty word
+     * @return The number of leaves
+     */
+    uint32_t leafCount(uint32_t node) const;
+
+    /*!
+     * Check if a node accepts the empty word
+     *
+     * @param node The node, or NO_NODE for the empty word
+     * @return true if the empty word is accepted, false otherwise
+     */
+    bool isNullable(uint32_t node) const;
+
+    /*!
+     * Return the positions that may be read first in a node, relative to its
+     * first leaf
+     *
+     * @param node The node, or NO_NODE for the empty word
+     * @return The positions, in increasing order
+     */
+    const vector<uint32_t> &first(uint32_t node) const;
+
+    /*!
+     * Return the positions that may be read last in a node, relative to its
+     * first leaf
+     *
+     * @param node The node, or NO_NODE for the empty word
+     * @return The positions, in increasing order
+     */
+    const vector<uint32_t> &last(uint32_t node) const;
+
+    /*!
+     * Compute the positions of the whole expression. Each occurrence of a
+     * concatenation or a repetition adds its follow pairs with the cached
+     * first and last positions of its children.
+     *
+     * @return The positions of the expression
+     */
+    GlushkovPositions positions() const;
+
+    const static uint32_t NO_NODE; //!< A missing node (the empty word)
+private:
+    /*!
+     * A shared node
+     */
+    struct Shared {
+        NodeType type; //!< The type of the node
+        char value; //!< The value of the node
+        uint32_t left; //!< The left child
+        uint32_t right; //!< The right child
+        uint32_t leaves; //!< The number of leaves
+        bool nullable; //!< If the empty word is accepted
+        vector<uint32_t> first; //!< The first positions, relative
+        vector<uint32_t> last; //!< The last positions, relative
+    };
+
+    /*!
+     * Return the node with a type, a value and children, adding it if it was
+     * not built yet
+     *
+     * @param type  The type of the node
+     * @param value The value of the node
+     * @param left  The left child, or NO_NODE
+     * @param right The right child, or NO_NODE
+     * @return The node
+     */
+    uint32_t intern(NodeType type, char value, uint32_t left, uint32_t right);
+
+    /*!
+     * Append positions shifted by an offset
+     *
+     * @param positions The positions to extend
+     * @param other     The positions to append
+     * @param offset    The offset of the positions appended
+     */
+    static void append(vector<uint32_t> &positions,
+                       const vector<uint32_t> &other, uint32_t offset);
+
+    vector<Shared> nodes; //!< The shared nodes
+    map<pair<uint64_t, uint32_t>, uint32_t> ids; //!< The nodes, by children, type and value
+    vector<uint32_t> none; //!< The positions of the empty word
+    uint32_t top; //!< The node of the whole expression
+};
+#endif // EXPRESSION_DAG_H
@@ -111,25 +111,114 @@ FiniteAutomata::FiniteAutomata(const FiniteAutomata &f) {
     transitions = f.transitions;
     initial_state = f.initial_state;
     final_states = f.final_states;
+    compact = f.compact;
+    closures = f.closures;
 }
 
-bool FiniteAutomata::isDeterministic() const {
-    for (string state: states) {
-        if (!transitions.count(state)) {
+FiniteAutomata::FiniteAutomata(const CompactAutomata &compact) {
+    alphabet.insert(EPSILON);
+    for (uint32_t column = 0; column < compact.symbolCount(); column++) {
+        alphabet.insert(compact.symbolAt(column));
+    }
+    vector<string> names(compact.size());
+    int i = 0;
+    for (uint32_t state = 0; state < compact.size(); state++) {
+        names[state] = compact.stateName(state);
+        while (names[state].empty()) {
+            string name = "q" + to_string(i);
+            i++;
+            if (compact.findState(name) == CompactAutomata::NO_STATE) {
+                names[state] = name;
+            }
+        }
+        states.insert(names[state]);
+        if (compact.isFinalState(state)) {
+            final_states.insert(names[state]);
+        }
+    }
+    if (compact.initialState() != CompactAutomata::NO_STATE) {
+        initial_state = names[compact.initialState()];
+    }
+    for (uint32_t state = 0; state < compact.size(); state++) {
+        for (uint32_t column = 0; column < compact.symbolCount(); column++) {
+            StateRange targets = compact.successors(state, column);
+            if (targets.empty()) {
+                continue;
+            }
+            set<string> &transition = transitions[names[state]][compact.symbolAt(column)];
+            for (uint32_t target: targets) {
+                transition.insert(names[target]);
+            }
+        }
+        for (uint32_t target: compact.epsilonSuccessors(state)) {
+            transitions[names[state]][EPSILON].insert(names[target]);
+        }
+    }
+}
+
+shared_ptr<const CompactAutomata> FiniteAutomata::getCompact() const {
+    if (compact) {
+        return compact;
+    }
+    shared_ptr<CompactAutomata> result = make_shared<CompactAutomata>();
+    for (char symbol: alphabet) {
+        if (symbol != EPSILON) {
+            result->addSymbol(symbol);
+        }
+    }
+    for (const string &state: states) {
+        result->addState(state, final_states.count(state));
+    }
+    if (!initial_state.empty()) {
+        result->setInitialState(result->findState(initial_state));
+    }
+    for (auto &stateTransitions: transitions) {
+        uint32_t source = result->findState(stateTransitions.first);
+        if (source == CompactAutomata::NO_STATE) {
             continue;
         }
-        map<char, set<string> > stateTransitions = transitions.at(state);
-        set<string> closure = getClosure(state);
-        int closureSize = closure.size()-1;
+        for (auto &transition: stateTransitions.second) {
+            uint32_t column = result->symbolColumn(transition.first);
+            if (transition.first != EPSILON && column == CompactAutomata::NO_SYMBOL) {
+                continue;
+            }
+            for (const string &toState: transition.second) {
+                // Transitions to removed states may be kept in the map, so
+                // just ignore them
+                uint32_t target = result->findState(toState);
+                if (target == CompactAutomata::NO_STATE) {
+                    continue;
+                }
+                if (transition.first == EPSILON) {
+                    result->addEpsilonTransition(source, target);
+                } else {
+                    result->addTransition(source, column, target);
+                }
+            }
+        }
+    }
+    result->compile();
+    compact = result;
+    return compact;
+}
+
+shared_ptr<const EpsilonClosure> FiniteAutomata::getClosures() const {
+    if (!closures) {
+        closures = make_shared<EpsilonClosure>(*getCompact());
+    }
+    return closures;
+}
+
+bool FiniteAutomata::isDeterministic() const {
+    shared_ptr<const CompactAutomata> c = getCompact();
+    shared_ptr<const EpsilonClosure> closure = getClosures();
+    for (uint32_t state = 0; state < c->size(); state++) {
+        int closureSize = closure->closure(state).size()-1;
         if (closureSize > 1) {
             return false;
         }
-        for (char symbol: alphabet) {
-            if (symbol == EPSILON || !stateTransitions.count(symbol)) {
-                continue;
-            }
-            set<string> transition = stateTransitions.at(symbol);
-            int exits = transition.size()+closureSize;
+        for (uint32_t column = 0; column < c->symbolCount(); column++) {
+            int exits = c->successors(state, column).size()+closureSize;
             if (exits > 1) {
                 return false;
             }
@@ -139,10 +228,11 @@ bool FiniteAutomata::isDeterministic() const {
 }
 
 void FiniteAutomata::addSymbol(char symbol) {
-    if ((symbol < '0' || symbol > '9') && (symbol < 'a' || symbol > 'z')) {
-        throw FiniteAutomataException("Symbol should be between '0' and '9' or between 'a' and 'z'");
+    if (symbol == EPSILON) {
+        throw FiniteAutomataException("The symbol '&' is reserved for epsilon transitions");
     }
     alphabet.insert(symbol);
+    invalidate(false);
 }
 
 void FiniteAutomata::addState(string state, int type) {
@@ -169,6 +259,7 @@ void FiniteAutomata::addState(string state, int type) {
     if (type & FINAL_STATE) {
         final_states.insert(state);
     }
+    invalidate();
 }
 
 bool FiniteAutomata::hasState(string state) const  {
@@ -196,42 +287,39 @@ set<char> FiniteAutomata::getAlphabet() const {
 }
 
 bool FiniteAutomata::isEmpty() const {
-    set<string> newStates;
-    queue<string> q;
-    for (string state: final_states) {
-        q.push(state);
-    }
-    while (!q.empty()) {
-        string state = q.front();
-        q.pop();
-        if (state == initial_state) {
-            return false;
-        }
-        newStates.insert(state);
-        for (string fromState: states) {
-            if (!transitions.count(fromState)) {
-                continue;
-            }
-            for (char symbol: alphabet) {
-                if (!transitions.at(fromState).count(symbol)) {
-                    continue;
-                }
-                if (transitions.at(fromState).at(symbol).count(state) &&
-                    !newStates.count(fromState)) {
-                    q.push(fromState);
-                }
-            }
-        }
+    if (initial_state.empty()) {
+        return true;
     }
-    return true;
+    shared_ptr<const CompactAutomata> c = getCompact();
+    return !c->coreachableStates()[c->initialState()];
 }
 
 bool FiniteAutomata::isEquivalent(FiniteAutomata other) const {
-    return isContained(other) && other.isContained(*this);
+    string counterexample;
+    return isEquivalent(other, counterexample);
+}
+
+bool FiniteAutomata::isEquivalent(FiniteAutomata other, string &counterexample) const {
+    if (initial_state.empty() || other.initial_state.empty()) {
+        throw FiniteAutomataException("Initial State should be defined to operate with the automata");
+    }
+    EquivalenceChecker checker(*getCompact(), *other.getCompact(),
+                               getClosures(), other.getClosures());
+    return checker.isEquivalent(counterexample);
 }
 
 bool FiniteAutomata::isContained(FiniteAutomata other) const {
-    return doDifference(other).isEmpty();
+    string counterexample;
+    return isContained(other, counterexample);
+}
+
+bool FiniteAutomata::isContained(FiniteAutomata other, string &counterexample) const {
+    if (initial_state.empty() || other.initial_state.empty()) {
+        throw FiniteAutomataException("Initial State should be defined to operate with the automata");
+    }
+    EquivalenceChecker checker(*getCompact(), *other.getCompact(),
+                               getClosures(), other.getClosures());
+    return checker.isContained(counterexample);
 }
 
 bool FiniteAutomata::hasTransition(string source, char symbol, string target) {
@@ -263,278 +351,78 @@ void FiniteAutomata::addTransition(string source, char symbol, string target) {
         throw FiniteAutomataException("Target State is not a valid state");
     }
     transitions[source][symbol].insert(target);
+    invalidate(symbol == EPSILON);
 }
 
-FiniteAutomata FiniteAutomata::determinize() const {
+FiniteAutomata FiniteAutomata::determinize(unsigned threads) const {
     if (initial_state.empty()) {
         throw FiniteAutomataException("Initial State should be defined to determinize automata");
     }
-    FiniteAutomata result(*this);
-    queue<set<string> > q;
-    set<string> initialState = getClosure(initial_state);
-    q.push(initialState);
-    result.initial_state = "";
-    while (!q.empty()) {
-        set<string> states = q.front();
-        q.pop();
-        string stateName = formatStates(states);
-        int type = 0;
-        if (states == initialState) {
-            type |= INITIAL_STATE;
-        }
-        for (string state: states) {
-            if (result.final_states.count(state)) {
-                type |= FINAL_STATE;
-                break;
-            }
-        }
-        result.addState(stateName, type);
-        map<char, set<string> > stateTransitions;
-        stateTransitions = result.transitions[stateName];
-        for (const char &symbol: result.alphabet) {
-            if (symbol == EPSILON) {
-                continue;
-            }
-            set<string> newTransitions;
-            for (string state: states) {
-                if (!result.transitions.count(state)) {
-                    continue;
-                }
-                set<string> transition = result.transitions[state][symbol];
-                newTransitions.insert(transition.begin(), transition.end());
-            }
-            for (string new_transition: newTransitions) {
-                set<string> closures = getClosure(new_transition);
-                newTransitions.insert(closures.begin(), closures.end());
-            }
-            if (newTransitions.empty()) {
-                continue;
-            }
-            string newTransitionsName = formatStates(newTransitions);
-            stateTransitions[symbol].insert(newTransitionsName);
-            if (result.states.count(newTransitionsName)) {
-                continue;
-            }
-            q.push(newTransitions);
-        }
-        result.transitions[stateName] = stateTransitions;
-    }
-    return result.removeUnreachableStates();
+    SubsetConstruction construction(*getCompact(), getClosures());
+    construction.setNames(true);
+    construction.setThreads(threads);
+    return FiniteAutomata(construction.determinize());
+}
+
+FiniteAutomata FiniteAutomata::removeEpsilonTransitions() const {
+    return FiniteAutomata(getClosures()->removeEpsilonTransitions(*getCompact()));
 }
 
 FiniteAutomata FiniteAutomata::removeUnreachableStates() const {
     if (initial_state.empty()) {
         throw FiniteAutomataException("Initial State should be defined to remove unreachable states");
     }
-    FiniteAutomata result(*this);
-    set<string> newStates;
-    queue<string> q;
-    q.push(result.initial_state);
-    while (!q.empty()) {
-        string state = q.front();
-        newStates.insert(state);
-        q.pop();
-        if (!result.transitions.count(state)) {
-            continue;
-        }
-        for (char symbol: result.alphabet) {
-            if (!result.transitions[state].count(symbol)) {
-                continue;
-            }
-            set<string> transition = result.transitions[state][symbol];
-            for (string toState: transition) {
-                if (newStates.count(toState)) {
-                    continue;
-                }
-                q.push(toState);
-            }
-        }
-    }
-    result.setStates(newStates);
-    return result;
+    return keepStates(getCompact()->reachableStates());
 }
 
 FiniteAutomata FiniteAutomata::removeDeadStates() const {
+    return keepStates(getCompact()->coreachableStates());
+}
+
+FiniteAutomata FiniteAutomata::trim() const {
+    if (initial_state.empty()) {
+        throw FiniteAutomataException("Initial State should be defined to trim the automata");
+    }
+    shared_ptr<const CompactAutomata> c = getCompact();
+    vector<bool> keep = c->reachableStates();
+    vector<bool> alive = c->coreachableStates();
+    for (size_t state = 0; state < keep.size(); state++) {
+        keep[state] = keep[state] && alive[state];
+    }
+    return keepStates(keep);
+}
+
+FiniteAutomata FiniteAutomata::keepStates(const vector<bool> &keep) const {
+    shared_ptr<const CompactAutomata> c = getCompact();
     FiniteAutomata result(*this);
     set<string> newStates;
-    queue<string> q;
-    for (string state: result.final_states) {
-        q.push(state);
-    }
-    while (!q.empty()) {
-        string state = q.front();
-        newStates.insert(state);
-        q.pop();
-        for (string fromState: result.states) {
-            if (!result.transitions.count(fromState)) {
-                continue;
-            }
-            for (char symbol: result.alphabet) {
-                if (!result.transitions[fromState].count(symbol)) {
-                    continue;
-                }
-                if (result.transitions[fromState][symbol].count(state)) {
-                    if (newStates.count(fromState)) {
-                        continue;
-                    }
-                    q.push(fromState);
-                }
-            }
+    for (uint32_t state = 0; state < c->size(); state++) {
+        if (keep[state]) {
+            newStates.insert(newStates.end(), c->stateName(state));
         }
     }
     result.setStates(newStates);
     return result;
 }
 
-FiniteAutomata FiniteAutomata::removeEquivalentStates() const {
+FiniteAutomata FiniteAutomata::removeEquivalentStates(unsigned threads) const {
     if (!isDeterministic()) {
         throw FiniteAutomataException("This method works only on deterministic finite automata");
     }
-    FiniteAutomata result(*this);
-    set<set<string> > oldEquivalenceClasses, newEquivalenceClasses;
-    set<string> K, KF;
-    K = result.final_states;
-    for (string state: result.states) {
-        if (K.count(state)) {
-            continue;
-        }
-        KF.insert(state);
-    }
-    KF.insert("&");
-    newEquivalenceClasses.insert(K);
-    newEquivalenceClasses.insert(KF);
-    while (oldEquivalenceClasses != newEquivalenceClasses) {
-        oldEquivalenceClasses = newEquivalenceClasses;
-        newEquivalenceClasses.clear();
-        for (set<string> equivalenceClass: oldEquivalenceClasses) {
-            map<list<int>, set<string>> equivalenceClasses;
-            for (string state: equivalenceClass) {
-                list<int> foundEquivalenceClasses;
-                for (char symbol: result.alphabet) {
-                    set<string> transition = result.transitions[state][symbol];
-                    int i = 0;
-                    for (set<string> foundEquivalenceClass: oldEquivalenceClasses) {
-                        bool found = false;
-                        if (transition.empty()) {
-                            if (foundEquivalenceClass.count("&")) {
-                                foundEquivalenceClasses.push_back(i);
-                                found = true;
-                            }
-                        } else {
-                            for (string toState: transition) {
-                                if (foundEquivalenceClass.count(toState)) {
-                                    foundEquivalenceClasses.push_back(i);
-                                    found = true;
-                                    break;
-                                }
-                            }
-                        }
-                        if (found) {
-                            break;
-                        }
-                        i++;
-                    }
-                }
-                equivalenceClasses[foundEquivalenceClasses].insert(state);
-            }
-            for (auto &item: equivalenceClasses) {
-                set<string> equivalenceClass = item.second;
-                newEquivalenceClasses.insert(equivalenceClass);
-            }
-        }
-    }
-    int i = 1;
-    set<string> newStates, newFinalStates;
-    string newInitialState;
-    map<set<string>, string> newNames;
-    map<string, set<string>> statesToEquivalenceClasses;
-    result.transitions.clear();
-    for (set<string> equivalenceClass: newEquivalenceClasses) {
-        string stateName = "q"+to_string(i);
-        stateName = formatStates(equivalenceClass, true);
-        bool isFinal = false;
-        for (string state: equivalenceClass) {
-            if (result.final_states.count(state)) {
-                isFinal = true;
-            }
-            if (state == "&" && equivalenceClass.size() == 1) {
-                stateName = "-";
-            }
-            statesToEquivalenceClasses[state] = equivalenceClass;
-        }
-        if (stateName == "-") {
-            continue;
-        }
-        if (equivalenceClass.count(result.initial_state)) {
-            // stateName = "q0"; // First state is always "q0"
-            newInitialState = stateName;
-        }
-        if (isFinal) {
-            newFinalStates.insert(stateName);
-        }
-        newNames[equivalenceClass] = stateName;
-        newStates.insert(stateName);
-        i++;
-    }
-    for (set<string> equivalenceClass: newEquivalenceClasses) {
-        string stateName = newNames[equivalenceClass];
-        for (string state: equivalenceClass) {
-            for (char symbol: result.alphabet) {
-                string toState;
-                if (transitions.count(state) &&
-                    transitions.at(state).count(symbol) &&
-                    !transitions.at(state).at(symbol).empty()
-                ) {
-                    for (string to: transitions.at(state).at(symbol)) {
-                        toState = to;
-                        // Just get the first element and break the loop..
-                        break;
-                    }
-                } else {
-                    toState = "&";
-                }
-                set<string> toEquivalenceClass = statesToEquivalenceClasses[toState];
-                if (toState == "&" && toEquivalenceClass.size() == 1) {
-                    // Epsilon without equivalent states..just ignore
-                    continue;
-                }
-                toState = newNames[toEquivalenceClass];
-                result.transitions[stateName][symbol].insert(toState);
-            }
-        }
-    }
-    result.setStates(newStates, newFinalStates);
-    result.initial_state = newInitialState;
-    return result;
+    Minimizer minimizer(*getCompact());
+    minimizer.setNames(true);
+    minimizer.setThreads(threads);
+    return FiniteAutomata(minimizer.minimize());
 }
 
 bool FiniteAutomata::accepts(string s) {
     if (initial_state.empty()) {
         throw FiniteAutomataException("Initial State should be defined to check if string is accepted");
     }
-    set <string> actualStates;
-    set<string> initialState = getClosure(initial_state);
-    actualStates.insert(initialState.begin(), initialState.end());
-    for (char symbol: s) {
-        if (!alphabet.count(symbol)) {
-            return false;
-        }
-        set <string> nextStates;
-        for (string state: actualStates) {
-            set<string> toStates = transitions[state][symbol];
-            for (string toState: toStates) {
-                set<string> transition = getClosure(toState);
-                nextStates.insert(transition.begin(), transition.end());
-            }
-        }
-        actualStates = nextStates;
-    }
-    for (string state: actualStates) {
-        if (final_states.count(state)) {
-            return true;
-        }
+    if (!matcher) {
+        matcher = make_shared<LazyDFA>(getCompact(), getClosures());
     }
-    return false;
+    return matcher->accepts(s);
 }
 
 bool FiniteAutomata::isComplete() const {
@@ -566,6 +454,7 @@ FiniteAutomata FiniteAutomata::complete() const {
             }
         }
     }
+    result.invalidate();
     return result;
 }
 
@@ -635,17 +524,9 @@ FiniteAutomata FiniteAutomata::doUnion(FiniteAutomata other) const {
     return result;
 }
 
-FiniteAutomata FiniteAutomata::doIntersection(FiniteAutomata other) const {
-    FiniteAutomata result, l1(*this), l2(other);
-    set<char> newAlphabet;
-    newAlphabet.insert(alphabet.begin(), alphabet.end());
-    newAlphabet.insert(other.alphabet.begin(), other.alphabet.end());
-    l1.alphabet = newAlphabet;
-    l2.alphabet = newAlphabet;
-    l1 = l1.doComplement();
-    l2 = l2.doComplement();
-    result = l1.doUnion(l2);
-    return result.doComplement();
+FiniteAutomata FiniteAutomata::doIntersection(FiniteAutomata other,
+                                              unsigned threads) const {
+    return doProduct(other, ProductConstruction::INTERSECTION, threads);
 }
 
 FiniteAutomata FiniteAutomata::doComplement() const {
@@ -657,13 +538,40 @@ FiniteAutomata FiniteAutomata::doComplement() const {
         }
     }
     result.final_states = newFinalStates;
+    result.invalidate(false);
     return result;
 }
 
 FiniteAutomata FiniteAutomata::doDifference(FiniteAutomata other) const {
-    FiniteAutomata l1(*this), l2(other);
-    l2 = l2.doComplement();
-    return l1.doIntersection(l2);
+    return doProduct(other, ProductConstruction::DIFFERENCE);
+}
+
+FiniteAutomata FiniteAutomata::doSymmetricDifference(FiniteAutomata other) const {
+    return doProduct(other, ProductConstruction::SYMMETRIC_DIFFERENCE);
+}
+
+FiniteAutomata FiniteAutomata::doProduct(const FiniteAutomata &other, int acceptance,
+                                         unsigned threads) const {
+    shared_ptr<const CompactAutomata> l1 = getDeterministicCompact(threads);
+    shared_ptr<const CompactAutomata> l2 = other.getDeterministicCompact(threads);
+    ProductConstruction product(*l1, *l2, acceptance);
+    product.setNames(true);
+    product.setThreads(threads);
+    return FiniteAutomata(product.build());
+}
+
+shared_ptr<const CompactAutomata> FiniteAutomata::getDeterministicCompact(unsigned threads) const {
+    if (initial_state.empty()) {
+        throw FiniteAutomataException("Initial State should be defined to operate with the automata");
+    }
+    shared_ptr<const CompactAutomata> c = getCompact();
+    if (c->isDeterministic()) {
+        return c;
+    }
+    SubsetConstruction construction(*c, getClosures());
+    construction.setNames(true);
+    construction.setThreads(threads);
+    return make_shared<const CompactAutomata>(construction.determinize());
 }
 
 
@@ -782,27 +690,6 @@ FiniteAutomata::FiniteAutomataGenerator FiniteAutomata::generates() {
     return FiniteAutomataGenerator(*this);
 }
 
-set<string> FiniteAutomata::getClosure(string state) const {
-    set<string> results = set<string>();
-    queue<string> q;
-    q.push(state);
-    while (!q.empty()) {
-        string s = q.front();
-        q.pop();
-        if (s.empty() || results.count(s)) {
-            continue;
-        }
-        results.insert(s);
-        if (!transitions.count(s) || !transitions.at(s).count(EPSILON)) {
-            continue;
-        }
-        for (string state: transitions.at(s).at(EPSILON)) {
-            q.push(state);
-        }
-    }
-    return results;
-}
-
 string FiniteAutomata::formatStates(set<string> states, bool brackets) {
     string s;
     if (brackets) {
@@ -834,6 +721,7 @@ void FiniteAutomata::setStates(set<string> newStates, set<string> finalStates) {
     }
     states = newStates;
     final_states = finalStates;
+    invalidate();
 }
 
 void FiniteAutomata::setStates(set<string> newStates) {
@@ -858,3 +746,11 @@ string FiniteAutomata::findFreeName() const {
     } while (!isFree);
     return name;
 }
+
+void FiniteAutomata::invalidate(bool closures) {
+    compact.reset();
+    matcher.reset();
+    if (closures) {
+        this->closures.reset();
+    }
+}
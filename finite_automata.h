@@ -2,6 +2,13 @@
 #define FINITE_AUTOMATA_H
 
 #include <all.h>
+#include "compact_automata.h"
+#include "subset_construction.h"
+#include "minimizer.h"
+#include "epsilon_closure.h"
+#include "lazy_dfa.h"
+#include "product_construction.h"
+#include "equivalence_checker.h"
 
 /*!
  * Exception that is emitted when an invalid operation is done in the
@@ -172,6 +179,33 @@ public:
      */
     FiniteAutomata(const FiniteAutomata &f);
 
+    /*!
+     * Convert a compact automata back into a Finite Automata. Anonymous states
+     * of the compact automata receive free names in the format "qN".
+     *
+     * @param compact The compact automata to convert
+     */
+    explicit FiniteAutomata(const CompactAutomata &compact);
+
+    /*!
+     * Return the compact representation of this finite automata, which is
+     * used by the algorithms of this class. It is built on demand and cached
+     * until the automata is modified.
+     *
+     * @return The compact representation of this finite automata
+     */
+    shared_ptr<const CompactAutomata> getCompact() const;
+
+    /*!
+     * Return the epsilon closures of the states of the compact representation
+     * of this finite automata. They are computed on demand and cached until
+     * the states or the epsilon transitions change, so they survive the
+     * changes in the other transitions and in the final states.
+     *
+     * @return The epsilon closures of this finite automata
+     */
+    shared_ptr<const EpsilonClosure> getClosures() const;
+
     /*!
      * Check if this finite automata is deterministic
      *
@@ -181,11 +215,12 @@ public:
     bool isDeterministic() const;
 
     /*!
-     * Add a symbol to the alphabet of this Finite Automata
+     * Add a symbol (any byte but EPSILON) to the alphabet of this Finite
+     * Automata
      *
      * @see FiniteAutomata::hasSymbol
      * @see FiniteAutomata::getAlphabet
-     * @throw FiniteAutomataException If the symbol is invalid
+     * @throw FiniteAutomataException If the symbol is EPSILON
      *
      * @param symbol The symbol to be added to the alphabet
      */
@@ -250,6 +285,19 @@ public:
      */
     bool isEquivalent(FiniteAutomata other) const;
 
+    /*!
+     * Return if this finite automata is equivalent to the finite automata
+     * passed into the parameter, stopping at the first word that is accepted
+     * by only one of them
+     *
+     * @param  other          The other automata to compare with this automata
+     * @param  counterexample Receives the word accepted by only one of the
+     * automata, if they are not equivalent
+     * @return                true if this automata is equivalent to the
+     * automata passed into the parameter
+     */
+    bool isEquivalent(FiniteAutomata other, string &counterexample) const;
+
     /*!
      * Return if this automata is contained in the finite automata passed
      * into the parameter
@@ -260,6 +308,19 @@ public:
      */
     bool isContained(FiniteAutomata other) const;
 
+    /*!
+     * Return if this automata is contained in the finite automata passed
+     * into the parameter, stopping at the first word that is accepted by this
+     * automata but not by the other
+     *
+     * @param  other          The other automata to compare with this automata
+     * @param  counterexample Receives the word accepted only by this automata,
+     * if it is not contained in the other
+     * @return                true if this automata is contained in the
+     * automata passed into the parameter
+     */
+    bool isContained(FiniteAutomata other, string &counterexample) const;
+
     /*!
      * Check if a state is final in the Finite Automata
      *
@@ -308,11 +369,26 @@ public:
     void addTransition(string source, char symbol, string target);
 
     /*!
-     * Determinize and return the deterministic finite automata
+     * Determinize and return the deterministic finite automata, whose states
+     * are named after the sets of states that they represent. The result is
+     * the same for any number of threads.
+     *
+     * @see SubsetConstruction
+     * @throw FiniteAutomataException If the initial state is not defined
      *
+     * @param threads The number of threads, or 0 to use one per core
      * @return The deterministic finite automata
      */
-    FiniteAutomata determinize() const;
+    FiniteAutomata determinize(unsigned threads = 1) const;
+
+    /*!
+     * Remove the epsilon transitions from the finite automata, returning a new
+     * finite automata with the same states and the same language, where each
+     * state has the transitions of its epsilon closure.
+     *
+     * @return The new finite automata without epsilon transitions
+     */
+    FiniteAutomata removeEpsilonTransitions() const;
 
     /*!
      * Remove the unreachable states from the finite automata, returning a
@@ -330,16 +406,39 @@ public:
      */
     FiniteAutomata removeDeadStates() const;
 
+    /*!
+     * Remove the unreachable states and the dead states from the finite
+     * automata in a single pass, returning a new finite automata where every
+     * state is reachable and reaches a final state. This is the same as
+     * removeDeadStates() followed by removeUnreachableStates(), in linear
+     * time.
+     *
+     * @throw FiniteAutomataException If the initial state is not defined
+     *
+     * @return The new trimmed finite automata
+     */
+    FiniteAutomata trim() const;
+
     /*!
      * Remove the equivalent states from the finite automata, returning a
-     * new finite automata without equivalent states.
+     * new finite automata without equivalent states. Missing transitions are
+     * handled natively, so dead states are removed too. The result is the
+     * same for any number of threads.
      *
+     * @see Minimizer
+     * @throw FiniteAutomataException If the automata is not deterministic
+     *
+     * @param threads The number of threads, or 0 to use one per core
      * @return The new finite automata without equivalent states
      */
-    FiniteAutomata removeEquivalentStates() const;
+    FiniteAutomata removeEquivalentStates(unsigned threads = 1) const;
 
     /*!
-     * Check if a string is accepted by the finite automata
+     * Check if a string is accepted by the finite automata. The states of the
+     * deterministic automata are built on demand and cached between calls
+     * (until the automata is modified).
+     *
+     * @see LazyDFA
      *
      * @param s the string to be checked
      * @return true if the string is accepted, false otherwise
@@ -376,13 +475,16 @@ public:
      * Do the intersection of the finite automata represented by this object
      * with the finite automata provided by the argument and return the new
      * finite automata that represents the intersection between these two
-     * finite automatas
+     * finite automatas, computed with a direct product construction. The
+     * result is the same for any number of threads.
      *
-     * @param other The other finite automata do to the intersection with this
-     * automata
+     * @see ProductConstruction
+     * @param other   The other finite automata do to the intersection with
+     *                this automata
+     * @param threads The number of threads, or 0 to use one per core
      * @return The intersection between this and other finite automatas
      */
-    FiniteAutomata doIntersection(FiniteAutomata other) const;
+    FiniteAutomata doIntersection(FiniteAutomata other, unsigned threads = 1) const;
 
     /*!
      * Return the complement of this finite automata
@@ -395,14 +497,28 @@ public:
      * Do the difference of the finite automata represented by this object
      * with the finite automata provided by the argument and return the new
      * finite automata that represents the difference between these two
-     * finite automatas
+     * finite automatas, computed with a direct product construction
      *
+     * @see ProductConstruction
      * @param other The other finite automata do to the difference with this
      * automata
      * @return The difference between this and other finite automatas
      */
     FiniteAutomata doDifference(FiniteAutomata other) const;
 
+    /*!
+     * Do the symmetric difference of the finite automata represented by this
+     * object with the finite automata provided by the argument and return the
+     * new finite automata that accepts the strings accepted by only one of
+     * these two finite automatas
+     *
+     * @see ProductConstruction
+     * @param other The other finite automata do to the symmetric difference
+     * with this automata
+     * @return The symmetric difference between this and other finite automatas
+     */
+    FiniteAutomata doSymmetricDifference(FiniteAutomata other) const;
+
     /*!
      * Return a representation of this finite automata in the format of an
      * ASCII table ready to be printed
@@ -437,15 +553,6 @@ public:
     const static int INITIAL_STATE; //!< Constant used to represent a initial state
     const static char EPSILON; //!< Constant that represent the Epsilon char
 private:
-    /*!
-     * Returns a set of the states reachable by epsilon transitions in this
-     * finite automata
-     *
-     * @param  state    The state to start the processing
-     * @return          The set of the states reachable via epsilon transitions
-     */
-    set<string> getClosure(string state) const;
-
     /*!
      * Set the new states and final states of this finite automata, deleting any
      * transitions from states that are not in these sets
@@ -471,10 +578,56 @@ private:
      */
     string findFreeName() const;
 
+    /*!
+     * Return a deterministic compact representation of this finite automata,
+     * which is the cached compact representation itself when it is already
+     * deterministic
+     *
+     * @throw FiniteAutomataException If the initial state is not defined
+     * @param threads The number of threads of the determinization
+     * @return A deterministic compact representation of this finite automata
+     */
+    shared_ptr<const CompactAutomata> getDeterministicCompact(unsigned threads = 1) const;
+
+    /*!
+     * Return a copy of this automata with only some of its states
+     *
+     * @param keep If each state should be kept, indexed by the IDs of the
+     *             compact automata
+     * @return The new finite automata
+     */
+    FiniteAutomata keepStates(const vector<bool> &keep) const;
+
+    /*!
+     * Compute the product construction between this finite automata and
+     * another one
+     *
+     * @see ProductConstruction
+     * @param other      The other finite automata
+     * @param acceptance The acceptance table of the product
+     * @param threads    The number of threads, or 0 to use one per core
+     * @return The product between these two finite automatas
+     */
+    FiniteAutomata doProduct(const FiniteAutomata &other, int acceptance,
+                             unsigned threads = 1) const;
+
+    /*!
+     * Discard the cached compact representation of this finite automata. Must
+     * be called every time the states, the alphabet or the transitions change.
+     *
+     * @param closures If the cached epsilon closures should be discarded too,
+     *                 which is needed only when the states or the epsilon
+     *                 transitions change
+     */
+    void invalidate(bool closures = true);
+
     set<string> states; //!< The set of states of this finite automata
     set<char> alphabet; //!< The set of symbols of the alphabet of this FA
     map<string, map<char, set<string> > > transitions; //!< The transitions of this AF
     string initial_state; //!< The initial state of this finite automata
     set<string> final_states; //!< The final states of this finite automata
+    mutable shared_ptr<const CompactAutomata> compact; //!< The cached compact representation
+    mutable shared_ptr<const EpsilonClosure> closures; //!< The cached epsilon closures
+    shared_ptr<LazyDFA> matcher; //!< The lazy deterministic automata used by accepts()
 };
 #endif // FINITE_AUTOMATA_H
@@ -251,10 +251,6 @@ void FiniteAutomataTable::validateAlphabet() {
         }
         string symbol = item->text().toStdString();
 
-        if (!symbol.empty() && symbol[0] != '&' && ((symbol[0] < '0' || symbol[0] > '9') && (symbol[0] < 'a' || symbol[0] > 'z'))) {
-            warn(item, "The symbol '"+symbol+"' is not valid");
-            continue;
-        }
         if (symbol.size() != 1) {
             warn(item, "The symbols of the alphabet should have size 1");
             continue;
@@ -429,7 +425,7 @@ FiniteAutomata FiniteAutomataTable::toAutomata() {
             continue;
         }
         string symbol = item->text().toStdString();
-        if (symbol.empty() || symbol.size() > 1 ||  symbol[0] == '&' || ((symbol[0] < '0' || symbol[0] > '9') && (symbol[0] < 'a' || symbol[0] > 'z'))) {
+        if (symbol.empty() || symbol.size() > 1 ||  symbol[0] == '&') {
             continue;
         }
         f.addSymbol(symbol.at(0));
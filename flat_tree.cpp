@@ -0,0 +1,90 @@
+#include "flat_tree.h"
+
+const uint32_t FlatTree::NO_NODE = UINT32_MAX;
+
+FlatTree::FlatTree(Node *tree): leaves(0) {
+    // Each node is visited before its children (false) and after them
+    // (true), when the indices of its children are on the top of the stack
+    vector<pair<Node*, bool>> visits;
+    vector<uint32_t> children;
+    if (tree->getType() != LAMBDA) {
+        visits.push_back(make_pair(tree, false));
+    }
+    while (!visits.empty()) {
+        Node *node = visits.back().first;
+        bool visited = visits.back().second;
+        visits.pop_back();
+        if (!node) {
+            children.push_back(NO_NODE);
+            continue;
+        }
+        NodeType type = node->getType();
+        bool binary = type == DOT || type == UNION;
+        if (!visited) {
+            visits.push_back(make_pair(node, true));
+            if (binary) {
+                visits.push_back(make_pair(node->getRight(), false));
+            }
+            if (type != LEAF) {
+                visits.push_back(make_pair(node->getLeft(), false));
+            }
+            continue;
+        }
+        uint32_t left = NO_NODE, right = NO_NODE;
+        if (binary) {
+            right = children.back();
+            children.pop_back();
+        }
+        if (type != LEAF) {
+            left = children.back();
+            children.pop_back();
+        }
+        children.push_back(types.size());
+        types.push_back(type);
+        values.push_back(node->getValue());
+        lefts.push_back(left);
+        rights.push_back(right);
+        positions.push_back(type == LEAF ? leaves++ : NO_NODE);
+    }
+    types.push_back(LAMBDA);
+    values.push_back('L');
+    lefts.push_back(children.empty() ? NO_NODE : children.back());
+    rights.push_back(NO_NODE);
+    positions.push_back(NO_NODE);
+}
+
+uint32_t FlatTree::size() const {
+    return types.size();
+}
+
+uint32_t FlatTree::leafCount() const {
+    return leaves;
+}
+
+uint32_t FlatTree::lambda() const {
+    return types.size()-1;
+}
+
+uint32_t FlatTree::top() const {
+    return lefts.back();
+}
+
+NodeType FlatTree::type(uint32_t node) const {
+    return types[node];
+}
+
+char FlatTree::value(uint32_t node) const {
+    return values[node];
+}
+
+uint32_t FlatTree::left(uint32_t node) const {
+    return lefts[node];
+}
+
+uint32_t FlatTree::right(uint32_t node) const {
+    return rights[node];
+}
+
+uint32_t FlatTree::position(uint32_t node) const {
+    return positions[node];
+}
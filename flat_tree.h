@@ -0,0 +1,101 @@
+#ifndef FLAT_TREE_H
+#define FLAT_TREE_H
+
+#include "all.h"
+#include "node.h"
+
+/*!
+ * A De Simone tree stored as parallel arrays indexed by node: the type, the
+ * value and the children of each node are plain values and 32 bit indices,
+ * with the nodes numbered in post-order (so the children of a node come
+ * before it, the leaves are numbered from left to right and the lambda node,
+ * the root, is the last one). The bottom up passes over the tree (like the
+ * ones of ExpressionDag and Derivatives) are plain loops over these arrays.
+ */
+class FlatTree {
+public:
+    /*!
+     * Constructs the flat representation of a tree
+     *
+     * @param tree The tree (or the lambda node alone for the empty language)
+     */
+    explicit FlatTree(Node *tree);
+
+    /*!
+     * Return the number of nodes, including the lambda node
+     *
+     * @return The number of nodes
+     */
+    uint32_t size() const;
+
+    /*!
+     * Return the number of leaves
+     *
+     * @return The number of leaves
+     */
+    uint32_t leafCount() const;
+
+    /*!
+     * Return the lambda node (the root of the tree)
+     *
+     * @return The lambda node
+     */
+    uint32_t lambda() const;
+
+    /*!
+     * Return the top of the tree (the child of the lambda node)
+     *
+     * @return The top of the tree, or NO_NODE if the tree is empty
+     */
+    uint32_t top() const;
+
+    /*!
+     * Return the type of a node
+     *
+     * @param node The node
+     * @return The type of the node
+     */
+    NodeType type(uint32_t node) const;
+
+    /*!
+     * Return the value of a node
+     *
+     * @param node The node
+     * @return The value of the node
+     */
+    char value(uint32_t node) const;
+
+    /*!
+     * Return the left child of a node
+     *
+     * @param node The node
+     * @return The left child, or NO_NODE
+     */
+    uint32_t left(uint32_t node) const;
+
+    /*!
+     * Return the right child of a node
+     *
+     * @param node The node
+     * @return The right child, or NO_NODE
+     */
+    uint32_t right(uint32_t node) const;
+
+    /*!
+     * Return the position of a leaf
+     *
+     * @param node The leaf
+     * @return The position of the leaf, between 0 and leafCount()-1
+     */
+    uint32_t position(uint32_t node) const;
+
+    const static uint32_t NO_NODE; //!< A missing node
+private:
+    vector<NodeType> types; //!< The type of each node
+    vector<char> values; //!< The value of each node
+    vector<uint32_t> lefts; //!< The left child of each node
+    vector<uint32_t> rights; //!< The right child of each node
+    vector<uint32_t> positions; //!< The position of each leaf
+    uint32_t leaves; //!< The number of leaves
+};
+#endif // FLAT_TREE_H
@@ -0,0 +1,77 @@
+#include "glushkov_matcher.h"
+
+template <size_t Words>
+GlushkovMatcher<Words>::GlushkovMatcher(const GlushkovPositions &positions):
+    nullable(positions.nullable) {
+    Mask empty;
+    fill(empty.words, empty.words+Words, 0);
+    first = last = empty;
+    symbols.assign(256, empty);
+    vector<Mask> follows(MAX_POSITIONS, empty);
+    for (size_t position = 0; position < positions.symbols.size(); position++) {
+        uint64_t bit = 1ULL << (position % 64);
+        symbols[(unsigned char) positions.symbols[position]].words[position/64] |= bit;
+        if (positions.last.contains(position)) {
+            last.words[position/64] |= bit;
+        }
+        Mask &mask = follows[position];
+        for (uint32_t next: positions.follow[position]) {
+            mask.words[next/64] |= 1ULL << (next % 64);
+        }
+    }
+    positions.first.forEach([&](uint32_t position) {
+        first.words[position/64] |= 1ULL << (position % 64);
+    });
+    // The entry of each byte is the entry of the byte without its lowest bit
+    // plus the follow set of the position of that bit
+    follow.assign(CHUNKS*256, empty);
+    for (size_t chunk = 0; chunk < CHUNKS; chunk++) {
+        for (uint32_t byte = 1; byte < 256; byte++) {
+            Mask &entry = follow[chunk*256+byte];
+            entry = follow[chunk*256+(byte & (byte-1))];
+            unite(entry, follows[chunk*8+__builtin_ctz(byte)]);
+        }
+    }
+}
+
+template <size_t Words>
+void GlushkovMatcher<Words>::unite(Mask &mask, const Mask &other) {
+    for (size_t word = 0; word < Words; word++) {
+        mask.words[word] |= other.words[word];
+    }
+}
+
+template <size_t Words>
+bool GlushkovMatcher<Words>::accepts(const string &word) const {
+    if (word.empty()) {
+        return nullable;
+    }
+    Mask next = first, active;
+    for (char symbol: word) {
+        const Mask &candidates = symbols[(unsigned char) symbol];
+        uint64_t any = 0;
+        for (size_t w = 0; w < Words; w++) {
+            active.words[w] = next.words[w] & candidates.words[w];
+            any |= active.words[w];
+        }
+        if (!any) {
+            return false;
+        }
+        fill(next.words, next.words+Words, 0);
+        for (size_t chunk = 0; chunk < CHUNKS; chunk++) {
+            uint32_t byte = (active.words[chunk/8] >> (chunk%8*8)) & 0xFF;
+            if (byte) {
+                unite(next, follow[chunk*256+byte]);
+            }
+        }
+    }
+    for (size_t w = 0; w < Words; w++) {
+        if (active.words[w] & last.words[w]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template class GlushkovMatcher<1>;
+template class GlushkovMatcher<4>;
@@ -0,0 +1,78 @@
+#ifndef GLUSHKOV_MATCHER_H
+#define GLUSHKOV_MATCHER_H
+
+#include "all.h"
+#include "state_set.h"
+
+/*!
+ * The positions of a regular expression (its leaves, numbered from left to
+ * right), as used by the construction of Glushkov: the symbol of each
+ * position, the positions that may be read first, the positions that may
+ * follow each position and the positions that may be read last. The first
+ * and last sets are bitsets indexed by position, and the follow sets are
+ * sorted lists, so they take memory in proportion to the follow pairs and
+ * not to the square of the number of positions.
+ */
+struct GlushkovPositions {
+    vector<char> symbols; //!< The symbol of each position
+    StateSet first; //!< The positions that may be read first
+    vector<vector<uint32_t>> follow; //!< The positions that may follow each position, in increasing order
+    StateSet last; //!< The positions that may be read last
+    bool nullable; //!< If the empty word is accepted
+};
+
+/*!
+ * This class checks if words are accepted by a regular expression with the
+ * bit-parallel simulation of its Glushkov automata: the set of the positions
+ * that may be read next is kept in Words machine words, one bit per
+ * position, so it handles up to 64*Words positions.
+ *
+ * Each step keeps the positions with the symbol read (with a precomputed mask
+ * per symbol) and replaces them by the union of their follow sets. That union
+ * is read from tables indexed by each byte of the set (from Navarro and
+ * Raffinot), so a step costs 8*Words lookups, without allocating anything.
+ */
+template <size_t Words>
+class GlushkovMatcher {
+public:
+    /*!
+     * Constructs a matcher for the positions of a regular expression
+     *
+     * @param positions The positions, which must be at most MAX_POSITIONS
+     */
+    explicit GlushkovMatcher(const GlushkovPositions &positions);
+
+    /*!
+     * Check if a word is accepted by the regular expression
+     *
+     * @param word The word to check
+     * @return true if the word is accepted, false otherwise
+     */
+    bool accepts(const string &word) const;
+
+    const static size_t MAX_POSITIONS = 64*Words; //!< The maximum number of positions
+private:
+    /*!
+     * A set of positions, one bit per position
+     */
+    struct Mask {
+        uint64_t words[Words]; //!< The bits of the set
+    };
+
+    /*!
+     * Add the positions of a set to another set
+     *
+     * @param mask  The set that receives the positions
+     * @param other The positions to add
+     */
+    static void unite(Mask &mask, const Mask &other);
+
+    const static size_t CHUNKS = 8*Words; //!< The number of bytes of a set
+
+    Mask first; //!< The positions that may be read first
+    Mask last; //!< The positions that may be read last
+    vector<Mask> symbols; //!< The positions of each symbol (256 entries)
+    vector<Mask> follow; //!< The union of the follow sets, indexed by chunk*256+byte
+    bool nullable; //!< If the empty word is accepted
+};
+#endif // GLUSHKOV_MATCHER_H
@@ -0,0 +1,148 @@
+#include "lazy_dfa.h"
+
+const size_t LazyDFA::DEFAULT_MEMORY = 8 << 20;
+
+const uint32_t LazyDFA::DEAD = UINT32_MAX-1;
+
+const uint32_t LazyDFA::UNKNOWN = UINT32_MAX;
+
+// The cache pays off when it is flushed after consuming at least this many
+// symbols per state that it can hold
+static const size_t SYMBOLS_PER_STATE = 10;
+
+// Number of flushes in a row that did not pay off before falling back to the
+// simulation of the non deterministic automata
+static const uint32_t THRASHING_LIMIT = 3;
+
+LazyDFA::LazyDFA(shared_ptr<const CompactAutomata> nfa,
+                 shared_ptr<const EpsilonClosure> closure, size_t memory):
+    nfa(nfa), closure(closure), initial_states(nfa->size()),
+    final_states(nfa->size()), start(UNKNOWN), consumed(0), thrashing(0),
+    flushes(0), fallbacks(0) {
+    for (uint32_t state = 0; state < nfa->size(); state++) {
+        if (nfa->isFinalState(state)) {
+            final_states.insert(state);
+        }
+    }
+    if (nfa->initialState() != CompactAutomata::NO_STATE) {
+        for (uint32_t state: closure->closure(nfa->initialState())) {
+            initial_states.insert(state);
+        }
+    }
+    // Each state costs its row of transitions, its set of states and about
+    // two slots of the hash table. At least two states are needed: the
+    // source and the target of a transition.
+    size_t cost = nfa->symbolCount()*sizeof(uint32_t) +
+        ((nfa->size()+63)/64)*sizeof(uint64_t) + sizeof(StateSet) +
+        2*sizeof(uint32_t);
+    capacity = max<size_t>(2, min<size_t>(memory/cost, DEAD));
+}
+
+void LazyDFA::step(const StateSet &states, uint32_t column, StateSet &result) const {
+    result.clear();
+    states.forEach([&](uint32_t state) {
+        for (uint32_t target: nfa->successors(state, column)) {
+            if (result.contains(target)) {
+                continue;
+            }
+            for (uint32_t reached: closure->closure(target)) {
+                result.insert(reached);
+            }
+        }
+    });
+}
+
+void LazyDFA::flush() {
+    if (consumed < (size_t) capacity*SYMBOLS_PER_STATE) {
+        thrashing++;
+    } else {
+        thrashing = 0;
+    }
+    table.clear();
+    transitions.clear();
+    finals.clear();
+    start = UNKNOWN;
+    consumed = 0;
+    flushes++;
+}
+
+uint32_t LazyDFA::addState(const StateSet &states) {
+    uint32_t id = table.find(states);
+    if (id != StateSetTable::NOT_FOUND) {
+        return id;
+    }
+    if (table.size() >= capacity) {
+        flush();
+    }
+    id = table.insert(states).first;
+    transitions.resize(transitions.size()+nfa->symbolCount(), UNKNOWN);
+    finals.push_back(states.intersects(final_states));
+    return id;
+}
+
+bool LazyDFA::simulate(StateSet states, const string &word, size_t position) const {
+    StateSet next(nfa->size());
+    for (size_t i = position; i < word.size() && !states.empty(); i++) {
+        uint32_t column = nfa->symbolColumn(word[i]);
+        if (column == CompactAutomata::NO_SYMBOL) {
+            return false;
+        }
+        step(states, column, next);
+        swap(states, next);
+    }
+    return states.intersects(final_states);
+}
+
+bool LazyDFA::accepts(const string &word) {
+    if (nfa->initialState() == CompactAutomata::NO_STATE) {
+        return false;
+    }
+    if (start == UNKNOWN) {
+        start = addState(initial_states);
+    }
+    uint32_t columns = nfa->symbolCount();
+    uint32_t state = start;
+    StateSet next(nfa->size());
+    for (size_t i = 0; i < word.size(); i++) {
+        uint32_t column = nfa->symbolColumn(word[i]);
+        if (column == CompactAutomata::NO_SYMBOL) {
+            return false;
+        }
+        uint32_t target = transitions[(size_t) state*columns+column];
+        if (target == UNKNOWN) {
+            step(table.at(state), column, next);
+            uint32_t previous = flushes;
+            target = next.empty() ? DEAD : addState(next);
+            if (flushes == previous) {
+                transitions[(size_t) state*columns+column] = target;
+            } else if (thrashing >= THRASHING_LIMIT) {
+                // The source state is gone, and the cache is not paying off
+                thrashing = 0;
+                fallbacks++;
+                return simulate(next, word, i+1);
+            }
+        }
+        if (target == DEAD) {
+            return false;
+        }
+        consumed++;
+        state = target;
+    }
+    return finals[state];
+}
+
+uint32_t LazyDFA::cacheSize() const {
+    return table.size();
+}
+
+uint32_t LazyDFA::cacheCapacity() const {
+    return capacity;
+}
+
+uint32_t LazyDFA::flushCount() const {
+    return flushes;
+}
+
+uint32_t LazyDFA::fallbackCount() const {
+    return fallbacks;
+}
@@ -0,0 +1,126 @@
+#ifndef LAZY_DFA_H
+#define LAZY_DFA_H
+
+#include "all.h"
+#include "compact_automata.h"
+#include "epsilon_closure.h"
+#include "state_set.h"
+
+/*!
+ * This class checks if words are accepted by a (possibly non deterministic)
+ * automata, building the states of the deterministic automata only when the
+ * input reaches them, so each transition is computed once and then followed
+ * at the cost of a table lookup.
+ *
+ * The states built live in a cache with a memory budget, kept between calls.
+ * When the cache is full it is flushed (all the states are dropped and built
+ * again as needed). If the cache is flushed several times in a row without
+ * consuming enough input to pay for the states built, the automata is
+ * thrashing the cache, and the rest of the input is matched by simulating the
+ * non deterministic automata directly.
+ */
+class LazyDFA {
+public:
+    /*!
+     * Constructs a matcher over a compiled automata
+     *
+     * @param nfa     The automata
+     * @param closure The epsilon closures of the automata
+     * @param memory  The memory budget of the cache of states, in bytes
+     */
+    LazyDFA(shared_ptr<const CompactAutomata> nfa,
+            shared_ptr<const EpsilonClosure> closure,
+            size_t memory = DEFAULT_MEMORY);
+
+    /*!
+     * Check if a word is accepted by the automata
+     *
+     * @param word The word to check
+     * @return true if the word is accepted, false otherwise
+     */
+    bool accepts(const string &word);
+
+    /*!
+     * Return the number of states in the cache
+     *
+     * @return The number of states in the cache
+     */
+    uint32_t cacheSize() const;
+
+    /*!
+     * Return the maximum number of states in the cache, computed from the
+     * memory budget
+     *
+     * @return The maximum number of states in the cache
+     */
+    uint32_t cacheCapacity() const;
+
+    /*!
+     * Return how many times the cache was flushed
+     *
+     * @return The number of flushes
+     */
+    uint32_t flushCount() const;
+
+    /*!
+     * Return how many times the matcher gave up the cache and simulated the
+     * non deterministic automata
+     *
+     * @return The number of fallbacks
+     */
+    uint32_t fallbackCount() const;
+
+    const static size_t DEFAULT_MEMORY; //!< The default memory budget
+    const static uint32_t DEAD; //!< The transition to the empty set of states
+    const static uint32_t UNKNOWN; //!< A transition not built yet
+private:
+    /*!
+     * Compute the set of states reachable from a set of states by a symbol
+     * column, including the epsilon closures
+     *
+     * @param states The source set of states
+     * @param column The column of the symbol
+     * @param result The set where the result is stored (it is cleared first)
+     */
+    void step(const StateSet &states, uint32_t column, StateSet &result) const;
+
+    /*!
+     * Add a set of states to the cache, flushing the cache first if it is
+     * full
+     *
+     * @param states The set of states
+     * @return The ID of the state in the cache
+     */
+    uint32_t addState(const StateSet &states);
+
+    /*!
+     * Drop all the states of the cache
+     */
+    void flush();
+
+    /*!
+     * Check if a suffix of a word is accepted from a set of states by
+     * simulating the non deterministic automata
+     *
+     * @param states   The set of states before the suffix
+     * @param word     The word
+     * @param position The position where the suffix starts
+     * @return true if the suffix is accepted, false otherwise
+     */
+    bool simulate(StateSet states, const string &word, size_t position) const;
+
+    shared_ptr<const CompactAutomata> nfa; //!< The automata
+    shared_ptr<const EpsilonClosure> closure; //!< The epsilon closures
+    StateSet initial_states; //!< The closure of the initial state
+    StateSet final_states; //!< The final states of the automata
+    uint32_t capacity; //!< The maximum number of states in the cache
+    StateSetTable table; //!< The sets of states in the cache
+    vector<uint32_t> transitions; //!< The transitions of the cache, indexed by state*columns+column
+    vector<bool> finals; //!< If each state of the cache is final
+    uint32_t start; //!< The ID of the initial state in the cache (or UNKNOWN)
+    size_t consumed; //!< The symbols consumed since the last flush
+    uint32_t thrashing; //!< The number of flushes in a row that did not pay off
+    uint32_t flushes; //!< The number of flushes
+    uint32_t fallbacks; //!< The number of fallbacks to the simulation
+};
+#endif // LAZY_DFA_H
@@ -34,7 +34,26 @@ SOURCES += main.cpp\
     move_to_tab_button.cpp \
     regular_expression_highlighter.cpp \
     regular_expression_input.cpp \
-    regular_expression_tab.cpp
+    regular_expression_tab.cpp \
+    compact_automata.cpp \
+    state_set.cpp \
+    epsilon_closure.cpp \
+    lazy_dfa.cpp \
+    subset_construction.cpp \
+    minimizer.cpp \
+    product_construction.cpp \
+    equivalence_checker.cpp \
+    antichain_inclusion.cpp \
+    glushkov_matcher.cpp \
+    thompson_nfa.cpp \
+    pike_vm.cpp \
+    flat_tree.cpp \
+    derivatives.cpp \
+    simplifier.cpp \
+    expression_dag.cpp \
+    byte_classes.cpp \
+    utf8_ranges.cpp \
+    thread_pool.cpp
 
 HEADERS  += mainwindow.h \
     finite_automata.h \
@@ -47,7 +66,26 @@ HEADERS  += mainwindow.h \
     regular_expression_highlighter.h \
     regular_expression_input.h \
     regular_expression_tab.h \
-    automata_tab.h
+    automata_tab.h \
+    compact_automata.h \
+    state_set.h \
+    epsilon_closure.h \
+    lazy_dfa.h \
+    subset_construction.h \
+    minimizer.h \
+    product_construction.h \
+    equivalence_checker.h \
+    antichain_inclusion.h \
+    glushkov_matcher.h \
+    thompson_nfa.h \
+    pike_vm.h \
+    flat_tree.h \
+    derivatives.h \
+    simplifier.h \
+    expression_dag.h \
+    byte_classes.h \
+    utf8_ranges.h \
+    thread_pool.h
 
 FORMS    += mainwindow.ui
 
@@ -246,14 +246,23 @@ void MainWindow::checkContainment() {
     op->addStep(this, f.doComplement().doUnion(f2.doComplement().doComplement()), "Union of the complement of '"+name+"' with the complement of the complement of '"+f2Name+"':");
     op->addStep(this, f.doDifference(f2), "Complement of the union between the complement of '"+name+"' and the complement of the complement of '"+f2Name+"' (in other words, the result of the difference):");
     QString s = "Then, we check if the result of the difference between '"+name+"' and '"+f2Name+"' is empty. ";
-    if (f.isContained(f2)) {
+    string counterexample;
+    if (f.isContained(f2, counterexample)) {
         s += "In this case, it was. So we can conclude that '"+name+"' is contained inside '"+f2Name+"'.";
     } else {
-        s += "In this case, it was not. So we can conclude that '"+name+"' is NOT contained inside '"+f2Name+"'.";
+        s += "In this case, it was not. So we can conclude that '"+name+"' is NOT contained inside '"+f2Name+"'. ";
+        s += "For example, the sentence '"+formatSentence(counterexample)+"' is accepted by '"+name+"' but not by '"+f2Name+"'.";
     }
     op->addStep(s);
 }
 
+QString MainWindow::formatSentence(string sentence) {
+    if (sentence.empty()) {
+        return QString(QChar(FiniteAutomata::EPSILON));
+    }
+    return QString::fromStdString(sentence);
+}
+
 void MainWindow::showAutomata(OperationTab *op, AutomataTab *tab, QString name) {
     FiniteAutomata f = tab->toAutomata();
     if (RegularExpressionTab* re = dynamic_cast<RegularExpressionTab*>(tab)) {
@@ -310,13 +319,16 @@ void MainWindow::checkEquivalence() {
     op->addStep(this, f.doComplement().doUnion(f2.doComplement().doComplement()), "Union of the complement of '"+name+"' with the complement of the complement of '"+f2Name+"':");
     op->addStep(this, f.doDifference(f2), "Complement of the union between the complement of '"+name+"' and the complement of the complement of '"+f2Name+"' (in other words, the result of the difference):");
     QString s = "Then, we check if the result of the difference between '"+name+"' and '"+f2Name+"' is empty. ";
-    if (f.isContained(f2)) {
+    string counterexample;
+    bool contained = f.isContained(f2, counterexample);
+    if (contained) {
         s += "In this case, it is. So we can conclude that '"+name+"' is contained inside '"+f2Name+"'.";
     } else {
-        s += "In this case, it is not. So we can conclude that '"+name+"' is NOT contained inside '"+f2Name+"'.";
+        s += "In this case, it is not. So we can conclude that '"+name+"' is NOT contained inside '"+f2Name+"'. ";
+        s += "For example, the sentence '"+formatSentence(counterexample)+"' is accepted by '"+name+"' but not by '"+f2Name+"'.";
     }
     op->addStep(s);
-    if (f.isContained(f2)) {
+    if (contained) {
         op->addStep("Then, we need to check if '"+f2Name+"' is contained inside '"+name+"' to check if these automata are equivalent:");
         op->addStep(this, f.doComplement(), "This is the complement of the automata '"+name+"':");
         op->addStep("Then, we do the intersection between '"+f2Name+"' and the complement of '"+name+"'..");
@@ -325,11 +337,13 @@ void MainWindow::checkEquivalence() {
         op->addStep(this, f2.doComplement().doUnion(f.doComplement().doComplement()), "Union of the complement of '"+f2Name+"' with the complement of the complement of '"+name+"':");
         op->addStep(this, f2.doDifference(f), "Complement of the union between the complement of '"+f2Name+"' and the complement of the complement of '"+name+"' (in other words, the result of the difference):");
         s = "Then, we check if the result of the difference between '"+f2Name+"' and '"+name+"' is empty. ";
-        if (f2.isContained(f)) {
+        if (f2.isContained(f, counterexample)) {
             s += "In this case, it is. So we can conclude that '"+f2Name+"' is contained inside '"+name+"'.";
         } else {
-            s += "In this case, it is not. So we can conclude that '"+f2Name+"' is NOT contained inside '"+name+"'.";
+            s += "In this case, it is not. So we can conclude that '"+f2Name+"' is NOT contained inside '"+name+"'. ";
+            s += "For example, the sentence '"+formatSentence(counterexample)+"' is accepted by '"+f2Name+"' but not by '"+name+"'.";
         }
+        op->addStep(s);
     }
     if (f.isEquivalent(f2)) {
         op->addStep("Well, because '"+name+"' is contained inside '"+f2Name+"' and '"+f2Name+"' is contained inside '"+name+"'. So...these two automata are equivalent! :D");
@@ -436,16 +450,12 @@ void MainWindow::doMinimization() {
     FiniteAutomata f = fTab->toAutomata();
     showAutomata(op, fTab, name);
     op->addStep(this, f.removeDeadStates(), "This is the automata '"+name+"' without dead states:");
-    FiniteAutomata f2 = f.removeDeadStates();
-    bool hasInitialState = false;
-    for (string state: f2.getStates()) {
-        if (f2.isInitialState(state)) {
-            hasInitialState = true;
-        }
-    }
+    // The initial state is kept by removeDeadStates() only if the language
+    // is not empty
+    bool hasInitialState = !f.isEmpty();
     bool partial = false;
     if (hasInitialState) {
-        f = f2.removeUnreachableStates();
+        f = f.trim();
         op->addStep(this, f, "This is the automata '"+name+"' without dead states and without unreachable states:");
     } else {
         partial = true;
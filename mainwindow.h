@@ -188,6 +188,15 @@ private:
      */
     void showAutomata(OperationTab *op, AutomataTab *tab, QString name);
 
+    /*!
+     * Return a sentence in a format that can be shown to the user, where the
+     * empty sentence is shown as epsilon
+     *
+     * @param sentence The sentence to format
+     * @return The formatted sentence
+     */
+    QString formatSentence(string sentence);
+
     /*!
      * Return a list of the items actually opened
      * in the window
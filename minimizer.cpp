@@ -0,0 +1,322 @@
+#include "minimizer.h"
+
+Minimizer::Minimizer(const CompactAutomata &dfa): dfa(dfa), names(false),
+    threads(1) {
+    columns = dfa.symbolCount() + (dfa.hasEpsilonTransitions() ? 1 : 0);
+    // A state is alive if it can reach a final state
+    alive = dfa.coreachableStates();
+}
+
+void Minimizer::setNames(bool names) {
+    this->names = names;
+}
+
+void Minimizer::setThreads(unsigned threads) {
+    this->threads = threads;
+}
+
+uint32_t Minimizer::target(uint32_t state, uint32_t column) const {
+    if (column < dfa.symbolCount()) {
+        return dfa.successor(state, column);
+    }
+    StateRange targets = dfa.epsilonSuccessors(state);
+    return targets.empty() ? CompactAutomata::NO_STATE : *targets.begin();
+}
+
+StateRange Minimizer::sources(uint32_t state, uint32_t column) const {
+    if (column < dfa.symbolCount()) {
+        return dfa.predecessors(state, column);
+    }
+    return dfa.epsilonPredecessors(state);
+}
+
+vector<uint32_t> Minimizer::partition() const {
+    if (ThreadPool::resolve(threads) > 1) {
+        ThreadPool pool(threads);
+        return partition(pool);
+    }
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    uint32_t n = dfa.size();
+    // Refinable partition: the states of each block are contiguous in
+    // elements, between first and end, and the marked states of a block are
+    // moved to the front of it, up to mid
+    vector<uint32_t> elements, location(n, NONE), block(n, NONE);
+    vector<uint32_t> first, end, mid;
+    for (int final = 1; final >= 0; final--) {
+        uint32_t start = elements.size();
+        for (uint32_t state = 0; state < n; state++) {
+            if (alive[state] && dfa.isFinalState(state) == (bool) final) {
+                location[state] = elements.size();
+                block[state] = first.size();
+                elements.push_back(state);
+            }
+        }
+        if (elements.size() > start) {
+            first.push_back(start);
+            end.push_back(elements.size());
+            mid.push_back(start);
+        }
+    }
+    // Worklist of splitters (block, column); with partial transitions every
+    // block of the initial partition must be used as a splitter
+    vector<pair<uint32_t, uint32_t> > worklist;
+    vector<bool> waiting((size_t) max(n, 1u)*columns, false);
+    for (uint32_t b = 0; b < first.size(); b++) {
+        for (uint32_t column = 0; column < columns; column++) {
+            worklist.push_back(make_pair(b, column));
+            waiting[(size_t) b*columns+column] = true;
+        }
+    }
+    vector<uint32_t> predecessors, touched;
+    while (!worklist.empty()) {
+        uint32_t splitter = worklist.back().first;
+        uint32_t column = worklist.back().second;
+        worklist.pop_back();
+        waiting[(size_t) splitter*columns+column] = false;
+        predecessors.clear();
+        for (uint32_t i = first[splitter]; i < end[splitter]; i++) {
+            for (uint32_t source: sources(elements[i], column)) {
+                if (alive[source]) {
+                    predecessors.push_back(source);
+                }
+            }
+        }
+        // Mark the predecessors, moving them to the front of their blocks
+        touched.clear();
+        for (uint32_t state: predecessors) {
+            uint32_t b = block[state];
+            uint32_t i = location[state];
+            if (i < mid[b]) {
+                continue;
+            }
+            if (mid[b] == first[b]) {
+                touched.push_back(b);
+            }
+            uint32_t other = elements[mid[b]];
+            swap(elements[i], elements[mid[b]]);
+            location[other] = i;
+            location[state] = mid[b];
+            mid[b]++;
+        }
+        // Split the blocks that were partially marked
+        for (uint32_t b: touched) {
+            if (mid[b] == end[b]) {
+                mid[b] = first[b];
+                continue;
+            }
+            uint32_t created = first.size();
+            first.push_back(first[b]);
+            end.push_back(mid[b]);
+            mid.push_back(first[b]);
+            first[b] = mid[b];
+            for (uint32_t i = first[created]; i < end[created]; i++) {
+                block[elements[i]] = created;
+            }
+            for (uint32_t c = 0; c < columns; c++) {
+                size_t created_key = (size_t) created*columns+c;
+                if (waiting[(size_t) b*columns+c]) {
+                    waiting[created_key] = true;
+                    worklist.push_back(make_pair(created, c));
+                    continue;
+                }
+                uint32_t smaller = created;
+                if (end[b]-first[b] < end[created]-first[created]) {
+                    smaller = b;
+                }
+                waiting[(size_t) smaller*columns+c] = true;
+                worklist.push_back(make_pair(smaller, c));
+            }
+        }
+    }
+    // Number the classes in the order of their smallest state
+    vector<uint32_t> classes(n, NONE), numbers(first.size(), NONE);
+    uint32_t count = 0;
+    for (uint32_t state = 0; state < n; state++) {
+        if (block[state] == NONE) {
+            continue;
+        }
+        if (numbers[block[state]] == NONE) {
+            numbers[block[state]] = count++;
+        }
+        classes[state] = numbers[block[state]];
+    }
+    return classes;
+}
+
+vector<uint32_t> Minimizer::partition(ThreadPool &pool) const {
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    const uint32_t CHUNK = 4096;
+    uint32_t n = dfa.size();
+    size_t chunks = (n+CHUNK-1)/CHUNK, width = columns+1;
+    auto range = [&](size_t chunk) {
+        return make_pair((uint32_t) chunk*CHUNK, min(n, (uint32_t) (chunk+1)*CHUNK));
+    };
+    // The first round splits the final states from the others
+    vector<uint32_t> classes(n, NONE);
+    for (uint32_t state = 0; state < n; state++) {
+        if (alive[state]) {
+            classes[state] = dfa.isFinalState(state) ? 1 : 0;
+        }
+    }
+    // The signature of each state is its class and the classes of its targets
+    vector<uint32_t> signatures(n*width), leaders(n), numbers(n);
+    vector<uint64_t> hashes(n);
+    vector<uint32_t> counts(chunks);
+    auto same = [&](uint32_t a, uint32_t b) {
+        return equal(signatures.begin()+a*width, signatures.begin()+(a+1)*width,
+                     signatures.begin()+b*width);
+    };
+    // The smallest state of each signature, by hash
+    struct Shard {
+        mutex lock;
+        unordered_map<uint64_t, vector<uint32_t>> leaders;
+    };
+    vector<Shard> shards(64);
+    uint32_t previous = 0;
+    while (true) {
+        for (Shard &shard: shards) {
+            shard.leaders.clear();
+        }
+        pool.run(chunks, [&](size_t chunk, unsigned) {
+            auto bounds = range(chunk);
+            for (uint32_t state = bounds.first; state < bounds.second; state++) {
+                if (classes[state] == NONE) {
+                    continue;
+                }
+                uint32_t *signature = &signatures[state*width];
+                uint64_t hash = signature[0] = classes[state];
+                for (uint32_t column = 0; column < columns; column++) {
+                    uint32_t to = target(state, column);
+                    signature[column+1] = to == NONE ? NONE : classes[to];
+                    hash = (hash ^ signature[column+1])*0x9E3779B97F4A7C15ull;
+                }
+                hashes[state] = hash ^ (hash >> 29);
+                Shard &shard = shards[hashes[state] >> 58];
+                lock_guard<mutex> guard(shard.lock);
+                vector<uint32_t> &bucket = shard.leaders[hashes[state]];
+                auto leader = find_if(bucket.begin(), bucket.end(),
+                                      [&](uint32_t other) {
+                    return same(state, other);
+                });
+                if (leader == bucket.end()) {
+                    bucket.push_back(state);
+                } else if (state < *leader) {
+                    *leader = state;
+                }
+            }
+        });
+        // The leaders are numbered in the order of the states, with a count
+        // per chunk followed by the numbering of each chunk from its offset
+        pool.run(chunks, [&](size_t chunk, unsigned) {
+            counts[chunk] = 0;
+            auto bounds = range(chunk);
+            for (uint32_t state = bounds.first; state < bounds.second; state++) {
+                if (classes[state] == NONE) {
+                    continue;
+                }
+                Shard &shard = shards[hashes[state] >> 58];
+                for (uint32_t other: shard.leaders.find(hashes[state])->second) {
+                    if (same(state, other)) {
+                        leaders[state] = other;
+                    }
+                }
+                counts[chunk] += leaders[state] == state;
+            }
+        });
+        uint32_t count = 0;
+        for (uint32_t &offset: counts) {
+            uint32_t size = offset;
+            offset = count;
+            count += size;
+        }
+        pool.run(chunks, [&](size_t chunk, unsigned) {
+            uint32_t next = counts[chunk];
+            auto bounds = range(chunk);
+            for (uint32_t state = bounds.first; state < bounds.second; state++) {
+                if (classes[state] != NONE && leaders[state] == state) {
+                    numbers[state] = next++;
+                }
+            }
+        });
+        pool.run(chunks, [&](size_t chunk, unsigned) {
+            auto bounds = range(chunk);
+            for (uint32_t state = bounds.first; state < bounds.second; state++) {
+                if (classes[state] != NONE) {
+                    classes[state] = numbers[leaders[state]];
+                }
+            }
+        });
+        // A round that splits no class leaves the partition stable
+        if (count == previous) {
+            return classes;
+        }
+        previous = count;
+    }
+}
+
+CompactAutomata Minimizer::build(const vector<uint32_t> &classes) const {
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    CompactAutomata result;
+    for (uint32_t column = 0; column < dfa.symbolCount(); column++) {
+        result.addSymbol(dfa.symbolAt(column));
+    }
+    vector<uint32_t> representatives;
+    vector<vector<string> > members;
+    for (uint32_t state = 0; state < dfa.size(); state++) {
+        uint32_t c = classes[state];
+        if (c == NONE) {
+            continue;
+        }
+        if (c == representatives.size()) {
+            representatives.push_back(state);
+            members.push_back(vector<string>());
+        }
+        members[c].push_back(dfa.stateName(state));
+    }
+    uint32_t initial = dfa.initialState();
+    bool deadInitial = initial != NONE && classes[initial] == NONE;
+    if (deadInitial) {
+        members.push_back(vector<string>(1, dfa.stateName(initial)));
+    }
+    for (size_t c = 0; c < members.size(); c++) {
+        string name;
+        if (names) {
+            sort(members[c].begin(), members[c].end());
+            name = "[";
+            for (size_t i = 0; i < members[c].size(); i++) {
+                if (i > 0) {
+                    name.append(",");
+                }
+                name.append(members[c][i]);
+            }
+            name.append("]");
+        }
+        bool final = c < representatives.size() &&
+            dfa.isFinalState(representatives[c]);
+        result.addState(name, final);
+    }
+    if (deadInitial) {
+        result.setInitialState(representatives.size());
+    } else if (initial != NONE) {
+        result.setInitialState(classes[initial]);
+    }
+    for (uint32_t c = 0; c < representatives.size(); c++) {
+        for (uint32_t column = 0; column < columns; column++) {
+            uint32_t to = target(representatives[c], column);
+            if (to == NONE || classes[to] == NONE) {
+                continue;
+            }
+            if (column < dfa.symbolCount()) {
+                result.addTransition(c, column, classes[to]);
+            } else {
+                result.addEpsilonTransition(c, classes[to]);
+            }
+        }
+    }
+    result.compile();
+    return result;
+}
+
+CompactAutomata Minimizer::minimize() const {
+    return build(partition());
+}
@@ -0,0 +1,119 @@
+#ifndef MINIMIZER_H
+#define MINIMIZER_H
+
+#include "all.h"
+#include "compact_automata.h"
+#include "thread_pool.h"
+
+/*!
+ * This class implements the minimization of deterministic automata with the
+ * partition refinement algorithm of Hopcroft, in O(m log n), where m is the
+ * number of transitions and n is the number of states.
+ *
+ * Missing transitions are handled natively (as in the algorithm of Valmari
+ * and Lehtinen for partial automata), so there is no need to complete the
+ * automata with an error state first: all the blocks of the initial partition
+ * start in the worklist of splitters, and transitions to dead states (states
+ * that can not reach a final state) are treated as missing transitions.
+ *
+ * Epsilon transitions are accepted as long as each state has at most one of
+ * them, in which case epsilon is refined as if it was a regular symbol.
+ *
+ * With more than one thread, the partition is refined in rounds instead (as
+ * in the algorithm of Moore): the threads compute the signature of each
+ * state in a range (its class and the classes of its targets), the states
+ * with the same signature are grouped through a sharded hash table, and the
+ * new classes are numbered in the order of their smallest state. The rounds
+ * stop when no class is split, with the same classes of the sequential
+ * algorithm. Each round is linear, but the number of rounds may reach the
+ * number of states on long chains, where the sequential algorithm is better.
+ */
+class Minimizer {
+public:
+    /*!
+     * Constructs a minimizer over a compiled compact automata
+     *
+     * @param dfa The automata to minimize, which must be deterministic
+     */
+    explicit Minimizer(const CompactAutomata &dfa);
+
+    /*!
+     * Define if the states of the resulting automata should be named after
+     * the equivalence classes that they represent. By default, they are
+     * anonymous.
+     *
+     * @param names true to name the states, false otherwise
+     */
+    void setNames(bool names);
+
+    /*!
+     * Define the number of threads used to compute the equivalence classes.
+     * By default, it uses a single thread.
+     *
+     * @param threads The number of threads, or 0 to use one per core
+     */
+    void setThreads(unsigned threads);
+
+    /*!
+     * Compute the equivalence classes of the states of the automata. The
+     * classes are numbered in the order of their smallest state, so the
+     * numbering is stable.
+     *
+     * @return The class of each state, or CompactAutomata::NO_STATE for the
+     *         dead states
+     */
+    vector<uint32_t> partition() const;
+
+    /*!
+     * Return the automata where each equivalence class is a single state, and
+     * where the dead states are removed (unless the initial state is dead, in
+     * which case it is kept alone, without transitions)
+     *
+     * @return The minimal automata
+     */
+    CompactAutomata minimize() const;
+
+protected:
+    /*!
+     * Return the target of a transition, considering the epsilon column
+     *
+     * @param state  The source state
+     * @param column The column of the symbol (symbolCount() is epsilon)
+     * @return The target state or NO_STATE if there is no such transition
+     */
+    uint32_t target(uint32_t state, uint32_t column) const;
+
+    /*!
+     * Return the sources of the transitions to a state, considering the
+     * epsilon column
+     *
+     * @param state  The target state
+     * @param column The column of the symbol (symbolCount() is epsilon)
+     * @return The range of source states
+     */
+    StateRange sources(uint32_t state, uint32_t column) const;
+
+    /*!
+     * Compute the equivalence classes in rounds of refinement by signatures,
+     * on a pool of threads
+     *
+     * @param pool The threads
+     * @return The class of each state, the same of partition()
+     */
+    vector<uint32_t> partition(ThreadPool &pool) const;
+
+    /*!
+     * Build the automata from the classes computed by partition()
+     *
+     * @param classes The class of each state
+     * @return The minimal automata
+     */
+    CompactAutomata build(const vector<uint32_t> &classes) const;
+
+    const CompactAutomata &dfa; //!< The automata to minimize
+    uint32_t columns; //!< The number of columns (including epsilon)
+    vector<bool> alive; //!< If each state can reach a final state
+    bool names; //!< If the states of the result should have names
+    unsigned threads; //!< The number of threads (0 for one per core)
+};
+#endif // MINIMIZER_H
@@ -59,6 +59,10 @@ void Node::setLeft(Node *n) {
     this->left = n;
 }
 
+void Node::setRoot(Node *n) {
+    this->root = n;
+}
+
 list<NodeAction> DotNode::ascend() {
     list<NodeAction> neighbors;
     neighbors.push_back(NodeAction(this->getRight(), down));
@@ -176,3 +180,30 @@ list<NodeAction> UnionNode::descend() {
 NodeType UnionNode::getType() {
     return NodeType::UNION;
 }
+
+const size_t NodeArena::MIN_BLOCK = 4096;
+
+const size_t NodeArena::MAX_BLOCK = 1 << 20;
+
+NodeArena::NodeArena(): block_size(0), used(0), reserved(0), count(0) {}
+
+void* NodeArena::allocate(size_t bytes, size_t alignment) {
+    size_t offset = (used + alignment-1) & ~(alignment-1);
+    if (blocks.empty() || offset + bytes > block_size) {
+        block_size = max(bytes, min(MAX_BLOCK, max(MIN_BLOCK, 2*block_size)));
+        blocks.emplace_back(new char[block_size]);
+        reserved += block_size;
+        offset = 0;
+    }
+    used = offset + bytes;
+    count++;
+    return blocks.back().get() + offset;
+}
+
+size_t NodeArena::size() const {
+    return count;
+}
+
+size_t NodeArena::capacity() const {
+    return reserved;
+}
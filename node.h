@@ -116,6 +116,13 @@ class Node {
      */
     void setLeft(Node* n);
 
+    /*!
+     * Set the father of the node (by a direct relationship)
+     *
+     * @param n Node to be the father
+     */
+    void setRoot(Node* n);
+
     /*!
      * Get the list of NodeAction resulted by the descent routine of the node
      */
@@ -319,4 +326,64 @@ class UnionNode : public Node {
      */
     NodeType getType();
 };
+
+/*!
+ * A monotonic arena that owns all the nodes of a tree. Nodes are allocated by
+ * bumping a pointer inside large blocks (so the nodes of a tree are stored
+ * contiguously, in the order they were created), and are all released at
+ * once when the arena is destroyed. Nodes own no resources, so their
+ * destructors are never called.
+ */
+class NodeArena {
+  public:
+    /*!
+     * Constructs an empty arena
+     */
+    NodeArena();
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    /*!
+     * Constructs a node inside the arena
+     *
+     * @param v     The value associated to the node
+     * @param root  The father of the node (by a direct relationship)
+     * @return      The node, owned by the arena
+     */
+    template <typename T>
+    T* create(char v, Node *root) {
+        return new (allocate(sizeof(T), alignof(T))) T(v, root);
+    }
+
+    /*!
+     * Get the number of nodes in the arena
+     */
+    size_t size() const;
+
+    /*!
+     * Get the number of bytes reserved by the arena
+     */
+    size_t capacity() const;
+
+  private:
+    /*!
+     * Reserve memory for a node, starting a new block when the current one
+     * is full. Blocks double in size up to MAX_BLOCK bytes.
+     *
+     * @param bytes     The size of the node
+     * @param alignment The alignment of the node
+     * @return          The memory reserved
+     */
+    void* allocate(size_t bytes, size_t alignment);
+
+    const static size_t MIN_BLOCK; //!< The size of the first block
+    const static size_t MAX_BLOCK; //!< The maximum size of a block
+
+    vector<unique_ptr<char[]>> blocks; //!< The blocks of memory
+    size_t block_size; //!< The size of the current block
+    size_t used; //!< The bytes used in the current block
+    size_t reserved; //!< The bytes of all the blocks
+    size_t count; //!< The number of nodes allocated
+};
 #endif
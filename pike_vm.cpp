@@ -0,0 +1,50 @@
+#include "pike_vm.h"
+
+PikeVM::PikeVM(shared_ptr<const ThompsonNFA> nfa):
+    nfa(nfa), current(nfa->size()), next(nfa->size()) {
+    stack.reserve(nfa->size());
+}
+
+void PikeVM::addThread(SparseSet &threads, uint32_t state) {
+    if (!threads.insert(state)) {
+        return;
+    }
+    // Each state is pushed once, when it is inserted, so the stack never
+    // grows past the number of states
+    stack.push_back(state);
+    while (!stack.empty()) {
+        state = stack.back();
+        stack.pop_back();
+        if (nfa->kind(state) != ThompsonNFA::SPLIT) {
+            continue;
+        }
+        for (uint32_t target: {nfa->alternative(state), nfa->next(state)}) {
+            if (threads.insert(target)) {
+                stack.push_back(target);
+            }
+        }
+    }
+}
+
+bool PikeVM::accepts(const string &word) {
+    if (nfa->initialState() == ThompsonNFA::NO_STATE) {
+        return false;
+    }
+    current.clear();
+    addThread(current, nfa->initialState());
+    for (char symbol: word) {
+        next.clear();
+        for (uint32_t i = 0; i < current.count(); i++) {
+            uint32_t state = current.at(i);
+            if (nfa->kind(state) == ThompsonNFA::SYMBOL &&
+                    nfa->symbol(state) == symbol) {
+                addThread(next, nfa->next(state));
+            }
+        }
+        swap(current, next);
+        if (!current.count()) {
+            return false;
+        }
+    }
+    return current.contains(nfa->finalState());
+}
@@ -0,0 +1,50 @@
+#ifndef PIKE_VM_H
+#define PIKE_VM_H
+
+#include "all.h"
+#include "thompson_nfa.h"
+#include "state_set.h"
+
+/*!
+ * This class checks if words are accepted by the Thompson automata of a
+ * regular expression by simulating it like the virtual machine of Pike: it
+ * keeps the list of the states reached (the threads) and moves all of them
+ * one symbol at a time, so matching takes O(n*m) time for a word of size n
+ * and an automata with m states.
+ *
+ * The lists of threads are sparse sets allocated once, together with the
+ * stack used to follow the epsilon transitions, so matching a word does not
+ * allocate anything.
+ */
+class PikeVM {
+public:
+    /*!
+     * Constructs a matcher for a Thompson automata
+     *
+     * @param nfa The automata
+     */
+    explicit PikeVM(shared_ptr<const ThompsonNFA> nfa);
+
+    /*!
+     * Check if a word is accepted by the automata
+     *
+     * @param word The word to check
+     * @return true if the word is accepted, false otherwise
+     */
+    bool accepts(const string &word);
+private:
+    /*!
+     * Add a state and the states reachable from it by epsilon to a list of
+     * threads
+     *
+     * @param threads The list of threads
+     * @param state   The state to add
+     */
+    void addThread(SparseSet &threads, uint32_t state);
+
+    shared_ptr<const ThompsonNFA> nfa; //!< The automata
+    SparseSet current; //!< The threads before the symbol being read
+    SparseSet next; //!< The threads after the symbol being read
+    vector<uint32_t> stack; //!< The states whose epsilon transitions are pending
+};
+#endif // PIKE_VM_H
@@ -0,0 +1,206 @@
+#include "product_construction.h"
+
+const int ProductConstruction::INTERSECTION = 1 << 3;
+
+const int ProductConstruction::UNION = (1 << 3) | (1 << 2) | (1 << 1);
+
+const int ProductConstruction::DIFFERENCE = 1 << 2;
+
+const int ProductConstruction::SYMMETRIC_DIFFERENCE = (1 << 2) | (1 << 1);
+
+ProductConstruction::ProductConstruction(const CompactAutomata &left,
+                                         const CompactAutomata &right,
+                                         int acceptance):
+    left(left), right(right), acceptance(acceptance), names(false),
+    threads(1) {
+    set<char> alphabet;
+    for (uint32_t column = 0; column < left.symbolCount(); column++) {
+        alphabet.insert(left.symbolAt(column));
+    }
+    for (uint32_t column = 0; column < right.symbolCount(); column++) {
+        alphabet.insert(right.symbolAt(column));
+    }
+    for (char symbol: alphabet) {
+        symbols.push_back(symbol);
+        left_columns.push_back(left.symbolColumn(symbol));
+        right_columns.push_back(right.symbolColumn(symbol));
+    }
+}
+
+void ProductConstruction::setNames(bool names) {
+    this->names = names;
+}
+
+void ProductConstruction::setThreads(unsigned threads) {
+    this->threads = threads;
+}
+
+bool ProductConstruction::isFinal(uint32_t left, uint32_t right) const {
+    int index = 0;
+    if (left != CompactAutomata::NO_STATE && this->left.isFinalState(left)) {
+        index |= 2;
+    }
+    if (right != CompactAutomata::NO_STATE && this->right.isFinalState(right)) {
+        index |= 1;
+    }
+    return (acceptance >> index) & 1;
+}
+
+bool ProductConstruction::isUseful(uint32_t left, uint32_t right) const {
+    // Bits of the acceptance table that are still possible
+    int possible = 0xF;
+    if (left == CompactAutomata::NO_STATE) {
+        possible &= 0x3;
+    }
+    if (right == CompactAutomata::NO_STATE) {
+        possible &= 0x5;
+    }
+    return acceptance & possible;
+}
+
+string ProductConstruction::formatPair(uint32_t left, uint32_t right) const {
+    string s = "(";
+    s.append(left == CompactAutomata::NO_STATE ? "-" : this->left.stateName(left));
+    s.append(",");
+    s.append(right == CompactAutomata::NO_STATE ? "-" : this->right.stateName(right));
+    s.append(")");
+    return s;
+}
+
+CompactAutomata ProductConstruction::build() const {
+    if (ThreadPool::resolve(threads) > 1) {
+        ThreadPool pool(threads);
+        return build(pool);
+    }
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    CompactAutomata result;
+    for (char symbol: symbols) {
+        result.addSymbol(symbol);
+    }
+    vector<pair<uint32_t, uint32_t> > pairs;
+    unordered_map<uint64_t, uint32_t> ids;
+    pairs.push_back(make_pair(left.initialState(), right.initialState()));
+    ids[((uint64_t) pairs[0].first << 32) | pairs[0].second] = 0;
+    result.addState(names ? formatPair(pairs[0].first, pairs[0].second) : "",
+                    isFinal(pairs[0].first, pairs[0].second));
+    result.setInitialState(0);
+    // The pairs receive IDs in the order of discovery, so the vector of pairs
+    // is also the queue of the breadth-first search
+    for (uint32_t id = 0; id < pairs.size(); id++) {
+        uint32_t p = pairs[id].first, q = pairs[id].second;
+        for (uint32_t column = 0; column < symbols.size(); column++) {
+            uint32_t nextP = NONE, nextQ = NONE;
+            if (p != NONE && left_columns[column] != NONE) {
+                nextP = left.successor(p, left_columns[column]);
+            }
+            if (q != NONE && right_columns[column] != NONE) {
+                nextQ = right.successor(q, right_columns[column]);
+            }
+            if (!isUseful(nextP, nextQ)) {
+                continue;
+            }
+            uint64_t key = ((uint64_t) nextP << 32) | nextQ;
+            auto found = ids.find(key);
+            uint32_t target;
+            if (found == ids.end()) {
+                target = pairs.size();
+                ids[key] = target;
+                pairs.push_back(make_pair(nextP, nextQ));
+                result.addState(names ? formatPair(nextP, nextQ) : "",
+                                isFinal(nextP, nextQ));
+            } else {
+                target = found->second;
+            }
+            result.addTransition(id, column, target);
+        }
+    }
+    result.compile();
+    return result;
+}
+
+CompactAutomata ProductConstruction::build(ThreadPool &pool) const {
+    const uint32_t NONE = CompactAutomata::NO_STATE;
+    const uint32_t CHUNK = 256;
+    CompactAutomata result;
+    for (char symbol: symbols) {
+        result.addSymbol(symbol);
+    }
+    // The visited pairs, spread over shards by a hash of the pair; the ID of
+    // a pair is NONE until it is numbered by the merge of the buffers
+    struct Shard {
+        mutex lock;
+        unordered_map<uint64_t, uint32_t> ids;
+    };
+    vector<Shard> shards(64);
+    auto shard = [&](uint64_t key) -> Shard& {
+        return shards[(key*0x9E3779B97F4A7C15ull) >> 58];
+    };
+    // A transition found by a thread, whose target may not have an ID yet
+    struct Transition {
+        uint32_t source;
+        uint32_t column;
+        uint64_t key;
+        uint32_t *target;
+    };
+    vector<pair<uint32_t, uint32_t> > pairs;
+    pairs.push_back(make_pair(left.initialState(), right.initialState()));
+    uint64_t initial = ((uint64_t) pairs[0].first << 32) | pairs[0].second;
+    shard(initial).ids[initial] = 0;
+    result.addState(names ? formatPair(pairs[0].first, pairs[0].second) : "",
+                    isFinal(pairs[0].first, pairs[0].second));
+    result.setInitialState(0);
+    vector<vector<Transition> > buffers;
+    for (uint32_t level = 0; level < pairs.size();) {
+        uint32_t end = pairs.size();
+        size_t chunks = (end-level+CHUNK-1)/CHUNK;
+        if (buffers.size() < chunks) {
+            buffers.resize(chunks);
+        }
+        pool.run(chunks, [&](size_t chunk, unsigned) {
+            vector<Transition> &buffer = buffers[chunk];
+            buffer.clear();
+            uint32_t last = min(end, level+(uint32_t) (chunk+1)*CHUNK);
+            for (uint32_t id = level+chunk*CHUNK; id < last; id++) {
+                uint32_t p = pairs[id].first, q = pairs[id].second;
+                for (uint32_t column = 0; column < symbols.size(); column++) {
+                    uint32_t nextP = NONE, nextQ = NONE;
+                    if (p != NONE && left_columns[column] != NONE) {
+                        nextP = left.successor(p, left_columns[column]);
+                    }
+                    if (q != NONE && right_columns[column] != NONE) {
+                        nextQ = right.successor(q, right_columns[column]);
+                    }
+                    if (!isUseful(nextP, nextQ)) {
+                        continue;
+                    }
+                    uint64_t key = ((uint64_t) nextP << 32) | nextQ;
+                    Shard &visited = shard(key);
+                    lock_guard<mutex> guard(visited.lock);
+                    // The elements of an unordered_map are never moved
+                    uint32_t *target =
+                            &visited.ids.insert(make_pair(key, NONE)).first->second;
+                    buffer.push_back(Transition{id, column, key, target});
+                }
+            }
+        });
+        // The buffers are merged in the order of the sources, so the new
+        // pairs are numbered in the order of the sequential search
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            for (Transition &transition: buffers[chunk]) {
+                if (*transition.target == NONE) {
+                    uint32_t nextP = transition.key >> 32;
+                    uint32_t nextQ = transition.key & 0xFFFFFFFF;
+                    *transition.target = pairs.size();
+                    pairs.push_back(make_pair(nextP, nextQ));
+                    result.addState(names ? formatPair(nextP, nextQ) : "",
+                                    isFinal(nextP, nextQ));
+                }
+                result.addTransition(transition.source, transition.column,
+                                     *transition.target);
+            }
+        }
+        level = end;
+    }
+    result.compile();
+    return result;
+}
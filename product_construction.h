@@ -0,0 +1,116 @@
+#ifndef PRODUCT_CONSTRUCTION_H
+#define PRODUCT_CONSTRUCTION_H
+
+#include "all.h"
+#include "compact_automata.h"
+#include "thread_pool.h"
+
+/*!
+ * This class implements the product construction between two deterministic
+ * automata, exploring on the fly only the pairs of states (p, q) that are
+ * reachable from the pair of initial states.
+ *
+ * The acceptance of a pair is configurable through a table of 4 bits, indexed
+ * by (p is final)*2 + (q is final), so the same construction computes the
+ * intersection, the union, the difference or the symmetric difference.
+ *
+ * Missing transitions go to an implicit error state in each side, and the
+ * pairs from which no accepting pair can be reached because of it (like
+ * (p, error) in an intersection) are not created at all.
+ *
+ * With more than one thread, the search goes level by level: the threads
+ * take chunks of the pairs of a level, look up the targets of their
+ * transitions in a sharded table of visited pairs and write the transitions
+ * to a buffer per chunk. The buffers are then merged in order into the
+ * result, numbering the new pairs as the sequential search does, so the
+ * result is the same for any number of threads.
+ */
+class ProductConstruction {
+public:
+    /*!
+     * Constructs a product construction between two compiled deterministic
+     * automata (they may have different alphabets)
+     *
+     * @param left       The automata on the left side of the operation
+     * @param right      The automata on the right side of the operation
+     * @param acceptance The acceptance table of the pairs of states
+     */
+    ProductConstruction(const CompactAutomata &left, const CompactAutomata &right,
+                        int acceptance);
+
+    /*!
+     * Define if the states of the resulting automata should be named after
+     * the pairs of states that they represent, in the format "(p,q)" (where
+     * "-" represents the error state). By default, they are anonymous.
+     *
+     * @param names true to name the states, false otherwise
+     */
+    void setNames(bool names);
+
+    /*!
+     * Define the number of threads used by the construction. By default, it
+     * uses a single thread.
+     *
+     * @param threads The number of threads, or 0 to use one per core
+     */
+    void setThreads(unsigned threads);
+
+    /*!
+     * Run the construction, returning a compiled deterministic automata over
+     * the union of the alphabets. The initial state always has the ID 0.
+     *
+     * @return The product automata
+     */
+    CompactAutomata build() const;
+
+    const static int INTERSECTION; //!< Accept when both states are final
+    const static int UNION; //!< Accept when some state is final
+    const static int DIFFERENCE; //!< Accept when only the left state is final
+    const static int SYMMETRIC_DIFFERENCE; //!< Accept when only one state is final
+protected:
+    /*!
+     * Check if a pair of states is accepting
+     *
+     * @param left  The state on the left side (or NO_STATE)
+     * @param right The state on the right side (or NO_STATE)
+     * @return true if the pair is accepting, false otherwise
+     */
+    bool isFinal(uint32_t left, uint32_t right) const;
+
+    /*!
+     * Check if some accepting pair may be reachable from a pair of states,
+     * considering only which side is in the error state
+     *
+     * @param left  The state on the left side (or NO_STATE)
+     * @param right The state on the right side (or NO_STATE)
+     * @return false if no accepting pair is reachable, true otherwise
+     */
+    bool isUseful(uint32_t left, uint32_t right) const;
+
+    /*!
+     * Run the construction level by level, on a pool of threads
+     *
+     * @param pool The threads
+     * @return The product automata, the same of the sequential search
+     */
+    CompactAutomata build(ThreadPool &pool) const;
+
+    /*!
+     * Return the name of a pair of states
+     *
+     * @param left  The state on the left side (or NO_STATE)
+     * @param right The state on the right side (or NO_STATE)
+     * @return The name of the pair
+     */
+    string formatPair(uint32_t left, uint32_t right) const;
+
+    const CompactAutomata &left; //!< The automata on the left side
+    const CompactAutomata &right; //!< The automata on the right side
+    int acceptance; //!< The acceptance table of the pairs
+    vector<char> symbols; //!< The union of the alphabets
+    vector<uint32_t> left_columns; //!< The column of each symbol on the left
+    vector<uint32_t> right_columns; //!< The column of each symbol on the right
+    bool names; //!< If the states of the result should have names
+    unsigned threads; //!< The number of threads (0 for one per core)
+};
+#endif // PRODUCT_CONSTRUCTION_H
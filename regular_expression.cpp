@@ -1,91 +1,27 @@
 #include "regular_expression.h"
 
-RegularExpression::RegularExpression(string re) {
-    regex = re;
-}
+RegularExpressionException::RegularExpressionException(string message,
+                                                       size_t position):
+    runtime_error(message + " at position " + to_string(position)),
+    position(position) {}
 
-string RegularExpression::getRegularExpression() {
-    return regex;
+size_t RegularExpressionException::getPosition() const {
+    return position;
 }
 
-int RegularExpression::getLessPriority(string re) {
-    int pos = 0;
-    int less_priority = 3;
-    int count_parentesis = 0;
-    int subexpr = -1;
-    for (char& c : re) {
-        if (c == '(') {
-            count_parentesis++;
-        }
-
-        if (getOrder(c) < less_priority && count_parentesis == 0) {
-            less_priority = getOrder(c);
-            subexpr = pos;
-        }
-
-        if (c == ')') {
-            count_parentesis--;
-        }
-        pos++;
-    }
-    return subexpr;
-}
+const size_t RegularExpression::DEFAULT_STATE_BUDGET = 16384;
 
-string RegularExpression::normalize() {
-    string::iterator it = regex.begin();
-    string result;
-    if (it == regex.end()) {
-        return result;
-    }
-    char prev = *it;
-    result.append(1, prev);
-    string multipliers;
-    for (++it; it != regex.end(); ++it) {
-        char c = *it;
-        if (isMultiplier(c)) {
-            multipliers.append(1, c);
-            continue;
-        } else if(!multipliers.empty()) {
-            prev = fixMultipliers(multipliers);
-            result.append(1, prev);
-            multipliers = "";
-        }
-        if (shouldConcatenate(prev, c)) {
-            result.append(1, '.');
-        }
-        result.append(1, c);
-        prev = c;
-    }
-    if(!multipliers.empty()) {
-        prev = fixMultipliers(multipliers);
-        result.append(1, prev);
-        multipliers = "";
-    }
-    return result;
+RegularExpression::RegularExpression(string re, bool utf8):
+    utf8(utf8), budget(DEFAULT_STATE_BUDGET), tree(NULL), simplified(NULL) {
+    regex = re;
 }
 
-char RegularExpression::fixMultipliers(string multipliers) {
-    string::iterator mit = multipliers.begin();
-    char multiplier = *mit;
-    for (++mit; mit != multipliers.end(); ++mit) {
-        if (multiplier != *mit) {
-            multiplier = '*';
-            break;
-        }
-    }
-    return multiplier;
+void RegularExpression::setStateBudget(size_t budget) {
+    this->budget = budget;
 }
 
-
-int RegularExpression::getOrder(char c) {
-    if (c == '|') {
-        return 0;
-    } else if (c == '*' || c == '+' || c == '?') {
-        return 2;
-    } else if (c == '.') {
-        return 1;
-    }
-    return 3;
+string RegularExpression::getRegularExpression() {
+    return regex;
 }
 
 bool RegularExpression::isMultiplier(char c) {
@@ -93,209 +29,577 @@ bool RegularExpression::isMultiplier(char c) {
 }
 
 bool RegularExpression::isTerminal(char c) {
-    return !(c == '|' || isMultiplier(c) | (c == ')') || c == '(');
-}
-
-bool RegularExpression::shouldConcatenate(char prev, char c) {
-    bool pTerminal = isTerminal(prev);
-    bool cTerminal = isTerminal(c);
-    if (pTerminal && cTerminal) {
-        return true;
-    }
-    return (isMultiplier(prev) && cTerminal) ||
-            (((isMultiplier(prev) || pTerminal) && c == '(') ||
-            (prev == ')' && c == '(') ||
-            (prev == ')' && cTerminal));
+    return !(isOperator(c) || c == '[' || c == '.' || c == '\\');
 }
 
 Node* RegularExpression::getNode(char c, Node *root) {
     switch(c) {
-        case '.': return new DotNode(c, root);
-        case '|': return new UnionNode(c, root);
-        case '?': return new QuestionMarkNode(c, root);
-        case '*': return new StarNode(c, root);
-        case '+': return new PlusNode(c, root);
-        default: return new LeafNode(c, root);
+        case '.': return arena->create<DotNode>(c, root);
+        case '|': return arena->create<UnionNode>(c, root);
+        case '?': return arena->create<QuestionMarkNode>(c, root);
+        case '*': return arena->create<StarNode>(c, root);
+        case '+': return arena->create<PlusNode>(c, root);
+        default: return arena->create<LeafNode>(c, root);
     }
 }
 
 Node* RegularExpression::getTree() {
-    Node *root = new LambdaNode('L', 0);
-    Node *tree = getTree(normalize(), root);
     if (tree) {
-        root->setLeft(tree);
         return tree;
+    }
+    // A failed parse leaves its nodes in this arena until the next one
+    arena = make_shared<NodeArena>();
+    Node *root = arena->create<LambdaNode>('L', 0);
+    Node *parsed = parse();
+    if (parsed) {
+        root->setLeft(parsed);
+        parsed->setRoot(root);
+        tree = parsed;
     } else {
-        return root;
+        tree = root;
     }
+    return tree;
 }
 
-Node* RegularExpression::getTree(string re, Node *parent) {
-    int less_prior_position = getLessPriority(re);
-
-    int size = re.size();
-    while (less_prior_position == -1 && !(re.empty()) && re[0] == '(' &&
-            re[size-1] == ')') {
-        re = re.substr(1, size-2);
-        size = re.size();
-        less_prior_position = getLessPriority(re);
+Node* RegularExpression::getSimplifiedTree() {
+    if (simplified) {
+        return simplified;
     }
-
-    if (re.empty()) {
-        return NULL;
-    } else if (!(re.empty()) && less_prior_position == -1) {
-        return getNode(re[0], parent);
+    Node *original = getTree();
+    Node *root = arena->create<LambdaNode>('L', 0);
+    Node *top = Simplifier(*arena).simplify(original);
+    if (top) {
+        root->setLeft(top);
+        top->setRoot(root);
+        simplified = top;
+    } else {
+        simplified = root;
     }
+    return simplified;
+}
 
-    char op = re.at(less_prior_position);
-    Node* root = getNode(op, parent);
+Node* RegularExpression::join(const vector<Node*> &nodes, char operation) {
+    Node *tree = nodes.back();
+    for (size_t i = nodes.size()-1; i-- > 0;) {
+        Node *node = getNode(operation, 0);
+        node->setLeft(nodes[i]);
+        node->setRight(tree);
+        nodes[i]->setRoot(node);
+        tree->setRoot(node);
+        tree = node;
+    }
+    return tree;
+}
 
-    string subre_left = re.substr(0, less_prior_position);
-    string subre_right = re.substr(less_prior_position+1);
-    Node* left_child = getTree(subre_left, root);
-    Node* right_child = getTree(subre_right, root);
-    root->setLeft(left_child);
-    root->setRight(right_child);
+Node* RegularExpression::close(vector<Node*> &alternatives,
+                               vector<Node*> &factors, size_t position) {
+    if (factors.empty()) {
+        throw RegularExpressionException("Expected an expression", position);
+    }
+    alternatives.push_back(join(factors, '.'));
+    factors.clear();
+    Node *tree = join(alternatives, '|');
+    alternatives.clear();
+    return tree;
+}
 
-    return root;
+bool RegularExpression::isOperator(char c) {
+    return c == '|' || isMultiplier(c) || c == '(' || c == ')' || c == '{';
 }
 
-set<Node*> RegularExpression::getLeaves(list<NodeAction> to_process) {
-    set<Node*> composition;
-    set<NodeAction> visited;
-    while(!to_process.empty()) {
-        NodeAction child = to_process.back();
-        to_process.pop_back();
-        if (visited.count(child)) {
-            continue;
+size_t RegularExpression::readRepetition(size_t i, size_t &minimum,
+                                         size_t &maximum) {
+    size_t start = i++;
+    // Up to 9 digits, so the bounds do not overflow
+    auto number = [&](size_t &value) {
+        size_t digits = 0;
+        for (value = 0; i < regex.size() && isdigit(regex[i]) && digits < 9;
+                i++, digits++) {
+            value = value*10 + (regex[i]-'0');
         }
-        visited.insert(child);
-        Node *root = child.getNode();
-
-        if (root->getType() == LEAF || root->getType() == LAMBDA) {
-            composition.insert(root);
-        } else if (child.getDirection() == up) {
-            auto it = to_process.begin();
-            auto ascend = root->ascend();
-            to_process.insert(it, ascend.begin(), ascend.end());
-        } else if (child.getDirection() == down) {
-            auto it = to_process.begin();
-            auto descend = root->descend();
-            to_process.insert(it, descend.begin(), descend.end());
+        return digits > 0;
+    };
+    if (!number(minimum)) {
+        throw RegularExpressionException("Invalid repetition", start);
+    }
+    maximum = minimum;
+    if (i < regex.size() && regex[i] == ',') {
+        i++;
+        if (!number(maximum)) {
+            maximum = SIZE_MAX;
         }
     }
-
-    return composition;
+    if (i >= regex.size() || regex[i] != '}' || maximum < minimum) {
+        throw RegularExpressionException("Invalid repetition", start);
+    }
+    return i;
 }
 
-map<Node*, set<Node*>> RegularExpression::getCompositionPerLeaf(Node* tree) {
-    map<Node*, set<Node*>> table;
-    list<NodeAction> to_process;
-    Node *leaf;
-    queue<Node*> leaves;
-    Node *root = tree;
-
-    list<Node*> nodes;
-    nodes.push_back(root);
-
-    while (!nodes.empty()) {
-        root = nodes.back();
-        nodes.pop_back();
-
-        if (root->getType() == LEAF) {
-            leaves.push(root);
+Node* RegularExpression::copy(Node *node) {
+    auto clone = [&](Node *original) -> Node* {
+        if (original->getType() == LEAF) {
+            return arena->create<LeafNode>(original->getValue(), 0);
         }
-        if (root->getLeft()) {
-            nodes.push_back(root->getLeft());
+        return getNode(original->getValue(), 0);
+    };
+    Node *result = clone(node);
+    // The nodes copied whose children are not copied yet
+    vector<pair<Node*, Node*>> pending(1, make_pair(node, result));
+    while (!pending.empty()) {
+        Node *original = pending.back().first;
+        Node *copied = pending.back().second;
+        pending.pop_back();
+        if (original->getLeft()) {
+            Node *left = clone(original->getLeft());
+            copied->setLeft(left);
+            left->setRoot(copied);
+            pending.push_back(make_pair(original->getLeft(), left));
         }
-        if (root->getRight()) {
-            nodes.push_back(root->getRight());
+        if (original->getRight()) {
+            Node *right = clone(original->getRight());
+            copied->setRight(right);
+            right->setRoot(copied);
+            pending.push_back(make_pair(original->getRight(), right));
         }
     }
+    return result;
+}
 
-    while(!leaves.empty()) {
-        set<Node*> achievable;
-        leaf = leaves.front();
-        leaves.pop();
-        to_process = leaf->ascend();
-        achievable = getLeaves(to_process);
-        table[leaf] = achievable;
+Node* RegularExpression::repeat(Node *node, size_t minimum, size_t maximum,
+                                size_t position, size_t &leaves) {
+    if (maximum == 0) {
+        return arena->create<StarNode>('*', 0);
     }
-
-    return table;
+    size_t size = 0;
+    vector<Node*> pending(1, node);
+    while (!pending.empty()) {
+        Node *current = pending.back();
+        pending.pop_back();
+        size += current->getType() == LEAF;
+        for (Node *child: {current->getLeft(), current->getRight()}) {
+            if (child) {
+                pending.push_back(child);
+            }
+        }
+    }
+    // The subtree itself is the first copy
+    size_t copies = maximum == SIZE_MAX ? max<size_t>(minimum, 1) : maximum;
+    if (size && (copies-1 > (budget-min(budget, leaves))/size)) {
+        throw RegularExpressionException("Repetition exceeds the budget of " +
+                to_string(budget) + " states", position);
+    }
+    leaves += size*(copies-1);
+    bool first = true;
+    auto next = [&]() {
+        Node *result = first ? node : copy(node);
+        first = false;
+        return result;
+    };
+    auto wrap = [&](char multiplier, Node *child) {
+        Node *result = getNode(multiplier, 0);
+        result->setLeft(child);
+        child->setRoot(result);
+        return result;
+    };
+    vector<Node*> factors;
+    if (maximum == SIZE_MAX) {
+        for (size_t k = 1; k < copies; k++) {
+            factors.push_back(next());
+        }
+        factors.push_back(wrap(minimum ? '+' : '*', next()));
+        return join(factors, '.');
+    }
+    for (size_t k = 0; k < minimum; k++) {
+        factors.push_back(next());
+    }
+    // The optional copies are built from the innermost one
+    Node *optional = NULL;
+    for (size_t k = minimum; k < maximum; k++) {
+        Node *copied = next();
+        optional = wrap('?', optional ? join({copied, optional}, '.') : copied);
+    }
+    if (optional) {
+        factors.push_back(optional);
+    }
+    return join(factors, '.');
 }
 
-set<Node*> RegularExpression::getFirstComposition(Node* tree) {
-    Node *root = tree;
-    list<NodeAction> to_process = root->descend();
-
-    return getLeaves(to_process);
+size_t RegularExpression::readSymbol(size_t i, uint32_t &symbol) {
+    size_t start = i, end;
+    if (regex[i] == '\\' && i+1 == regex.size()) {
+        throw RegularExpressionException("Incomplete escape", i);
+    }
+    if (regex[i] == '\\' && regex[i+1] == 'x') {
+        string digits = regex.substr(i+2, 2);
+        if (digits.size() != 2 || !isxdigit(digits[0]) ||
+                !isxdigit(digits[1])) {
+            throw RegularExpressionException(
+                    "Expected two hexadecimal digits", i);
+        }
+        symbol = stoi(digits, 0, 16);
+        end = i+3;
+    } else {
+        if (regex[i] == '\\') {
+            i++;
+        }
+        size_t length = 1;
+        if (!utf8) {
+            symbol = (unsigned char) regex[i];
+        } else if (!(length = Utf8Ranges::decode(regex, i, symbol))) {
+            throw RegularExpressionException("Invalid UTF-8", i);
+        }
+        end = i+length-1;
+    }
+    if (symbol == (unsigned char) FiniteAutomata::EPSILON) {
+        throw RegularExpressionException(
+                "The symbol '&' is reserved for epsilon transitions", start);
+    }
+    return end;
 }
 
-set<char> RegularExpression::getAlphabet(map<Node*, set<Node*>> leaves_comp) {
-    set<char> alphabet;
-    for (auto &l : leaves_comp) {
-        alphabet.insert(l.first->getValue());
+size_t RegularExpression::readAtom(size_t i,
+                                   vector<pair<uint32_t, uint32_t>> &ranges) {
+    uint32_t last = utf8 ? Utf8Ranges::MAX_CODE_POINT : 0xFF;
+    uint32_t symbol;
+    size_t start = i;
+    if (regex[i] == '.') {
+        ranges.push_back(make_pair(0, last));
+    } else if (regex[i] != '[') {
+        i = readSymbol(i, symbol);
+        ranges.push_back(make_pair(symbol, symbol));
+    } else {
+        i++;
+        bool negated = i < regex.size() && regex[i] == '^';
+        if (negated) {
+            i++;
+        }
+        vector<pair<uint32_t, uint32_t>> members;
+        // A ']' right after the '[' (or the '[^') is a member of the class
+        for (bool first = true; ; first = false, i++) {
+            if (i >= regex.size()) {
+                throw RegularExpressionException("Unbalanced '['", start);
+            }
+            if (regex[i] == ']' && !first) {
+                break;
+            }
+            size_t position = i;
+            i = readSymbol(i, symbol);
+            uint32_t low = symbol;
+            if (i+2 < regex.size() && regex[i+1] == '-' && regex[i+2] != ']') {
+                i = readSymbol(i+2, symbol);
+                if (symbol < low) {
+                    throw RegularExpressionException("Invalid range", position);
+                }
+            }
+            members.push_back(make_pair(low, symbol));
+        }
+        sort(members.begin(), members.end());
+        // The ranges are merged, or complemented if the class is negated
+        uint32_t next = 0;
+        for (auto &member: members) {
+            if (negated && member.first > next) {
+                ranges.push_back(make_pair(next, member.first-1));
+            } else if (!negated && !ranges.empty() &&
+                    member.first <= ranges.back().second+1) {
+                ranges.back().second = max(ranges.back().second, member.second);
+            } else if (!negated) {
+                ranges.push_back(member);
+            }
+            next = max(next, member.second+1);
+        }
+        if (negated && next <= last) {
+            ranges.push_back(make_pair(next, last));
+        }
     }
-
-    return alphabet;
+    // The byte '&' marks the epsilon transitions of the automata, so it is
+    // left out of '.', the ranges and the negated classes. The surrogates are
+    // not code points of UTF-8.
+    vector<pair<uint32_t, uint32_t>> holes = {make_pair(
+            (unsigned char) FiniteAutomata::EPSILON,
+            (unsigned char) FiniteAutomata::EPSILON)};
+    if (utf8) {
+        holes.push_back(make_pair(Utf8Ranges::FIRST_SURROGATE,
+                                  Utf8Ranges::LAST_SURROGATE));
+    }
+    for (auto &hole: holes) {
+        vector<pair<uint32_t, uint32_t>> kept;
+        for (auto &range: ranges) {
+            if (range.first < hole.first) {
+                kept.push_back(make_pair(range.first,
+                                         min(range.second, hole.first-1)));
+            }
+            if (range.second > hole.second) {
+                kept.push_back(make_pair(max(range.first, hole.second+1),
+                                         range.second));
+            }
+        }
+        ranges = kept;
+    }
+    if (ranges.empty()) {
+        throw RegularExpressionException("Empty character class", start);
+    }
+    return i;
 }
 
-bool RegularExpression::hasLambda(set<Node*> composition) {
-    for (Node *cps : composition) {
-        if (cps->getType() == LAMBDA) {
-            return true;
+vector<vector<StateSet>> RegularExpression::getSequences(
+        const vector<pair<uint32_t, uint32_t>> &ranges) {
+    vector<vector<StateSet>> sequences;
+    // The bytes of all the sequences of a single byte are a single set
+    StateSet single(256);
+    for (auto &range: ranges) {
+        if (!utf8 || range.second < 0x80) {
+            for (uint32_t byte = range.first; byte <= range.second; byte++) {
+                single.insert(byte);
+            }
+            continue;
+        }
+        for (auto &sequence: Utf8Ranges::compile(range.first, range.second)) {
+            vector<StateSet> sets;
+            for (auto &bytes: sequence) {
+                sets.push_back(StateSet(256));
+                for (uint32_t byte = bytes.first; byte <= bytes.second; byte++) {
+                    sets.back().insert(byte);
+                }
+            }
+            if (sets.size() == 1) {
+                single.unite(sets[0]);
+            } else {
+                sequences.push_back(sets);
+            }
         }
     }
-    return false;
+    if (!single.empty()) {
+        sequences.insert(sequences.begin(), vector<StateSet>(1, single));
+    }
+    return sequences;
 }
 
-FiniteAutomata RegularExpression::getAutomata() {
-    Node *tree = getTree();
-    map<Node*, set<Node*>> compositions = getCompositionPerLeaf(tree);
+Node* RegularExpression::parse() {
+    classes = ByteClasses();
+    if (regex.empty()) {
+        return NULL;
+    }
+    // The sets of bytes of the atoms (literals, character classes and '.')
+    // are read first, so the byte classes are known when the tree is built.
+    // Each atom is a union of sequences of sets of bytes (a single set, out
+    // of UTF-8).
+    struct Atom {
+        size_t end;
+        vector<vector<StateSet>> sequences;
+    };
+    vector<Atom> atoms;
+    set<StateSet> sets;
+    size_t size = regex.size();
+    for (size_t i = 0; i < size; i++) {
+        if (regex[i] == '{') {
+            size_t minimum, maximum;
+            i = readRepetition(i, minimum, maximum);
+        } else if (!isOperator(regex[i])) {
+            vector<pair<uint32_t, uint32_t>> ranges;
+            size_t end = i = readAtom(i, ranges);
+            atoms.push_back(Atom{end, getSequences(ranges)});
+            for (auto &sequence: atoms.back().sequences) {
+                for (auto &bytes: sequence) {
+                    if (sets.insert(bytes).second) {
+                        classes.split(bytes);
+                    }
+                }
+            }
+        }
+    }
 
-    set<Node*> first_composition = getFirstComposition(tree);
+    // The alternatives and the factors of each open parenthesis, with the
+    // whole expression at the bottom
+    vector<vector<Node*>> alternatives(1), factors(1);
+    vector<size_t> parentheses;
+    size_t next = 0, leaves = 0;
+    for (size_t i = 0; i < size; i++) {
+        char c = regex[i];
+        if (c == '(') {
+            parentheses.push_back(i);
+            alternatives.emplace_back();
+            factors.emplace_back();
+        } else if (c == ')') {
+            if (parentheses.empty()) {
+                throw RegularExpressionException("Unbalanced ')'", i);
+            }
+            Node *group = close(alternatives.back(), factors.back(), i);
+            parentheses.pop_back();
+            alternatives.pop_back();
+            factors.pop_back();
+            factors.back().push_back(group);
+        } else if (c == '|') {
+            if (factors.back().empty()) {
+                throw RegularExpressionException("Expected an expression", i);
+            }
+            alternatives.back().push_back(join(factors.back(), '.'));
+            factors.back().clear();
+        } else if (isMultiplier(c)) {
+            if (factors.back().empty()) {
+                throw RegularExpressionException("Nothing to repeat", i);
+            }
+            char multiplier = c;
+            while (i+1 < size && isMultiplier(regex[i+1])) {
+                if (regex[++i] != c) {
+                    multiplier = '*';
+                }
+            }
+            Node *node = getNode(multiplier, 0);
+            node->setLeft(factors.back().back());
+            factors.back().back()->setRoot(node);
+            factors.back().back() = node;
+        } else if (c == '{') {
+            if (factors.back().empty()) {
+                throw RegularExpressionException("Nothing to repeat", i);
+            }
+            size_t minimum, maximum, position = i;
+            i = readRepetition(i, minimum, maximum);
+            factors.back().back() = repeat(factors.back().back(), minimum,
+                                           maximum, position, leaves);
+        } else {
+            // Each set of bytes is a union of the representatives of its
+            // classes
+            Atom &atom = atoms[next++];
+            vector<Node*> sequences;
+            for (auto &sequence: atom.sequences) {
+                vector<Node*> sets;
+                for (auto &bytes: sequence) {
+                    vector<Node*> symbols;
+                    for (char symbol: classes.representatives(bytes)) {
+                        symbols.push_back(arena->create<LeafNode>(symbol, 0));
+                    }
+                    leaves += symbols.size();
+                    sets.push_back(join(symbols, '|'));
+                }
+                sequences.push_back(join(sets, '.'));
+            }
+            factors.back().push_back(join(sequences, '|'));
+            i = atom.end;
+        }
+    }
+    if (!parentheses.empty()) {
+        throw RegularExpressionException("Unbalanced '('", parentheses.back());
+    }
+    return close(alternatives.back(), factors.back(), size);
+}
 
-    set<char> alphabet = getAlphabet(compositions);
-    FiniteAutomata automata;
+FiniteAutomata RegularExpression::getAutomata() {
+    GlushkovPositions positions = getPositions();
+    uint32_t count = positions.symbols.size();
+    set<char> alphabet(positions.symbols.begin(), positions.symbols.end());
+    // The states are built with their IDs and named q0, q1, ... only when
+    // the automata is converted at the end
+    CompactAutomata dfa;
+
+    // The symbols are numbered in alphabetical order, so the transitions of
+    // each state are added in the same order as the alphabet
+    vector<char> symbols(alphabet.begin(), alphabet.end());
+    for (char s : symbols) {
+        dfa.addSymbol(s);
+    }
+    vector<uint32_t> columns(count);
+    for (uint32_t position = 0; position < count; position++) {
+        columns[position] = lower_bound(symbols.begin(), symbols.end(),
+                positions.symbols[position]) - symbols.begin();
+    }
 
-    for (char s : alphabet) {
-        automata.addSymbol(s);
+    // Each state is a set of positions that may be read next, plus the
+    // position count (like the lambda node) if the state is final. The
+    // composition of each position is its follow list, plus the position
+    // count if it is the last one.
+    uint32_t lambda = count;
+    vector<vector<uint32_t>> &compositions = positions.follow;
+    for (uint32_t position = 0; position < count; position++) {
+        if (positions.last.contains(position)) {
+            compositions[position].push_back(lambda);
+        }
+    }
+    StateSet first_composition(count+1);
+    positions.first.forEach([&](uint32_t position) {
+        first_composition.insert(position);
+    });
+    if (positions.nullable) {
+        first_composition.insert(lambda);
     }
 
-    automata.addState("q0", FiniteAutomata::INITIAL_STATE |
-            (hasLambda(first_composition) ? FiniteAutomata::FINAL_STATE : 0));
+    StateSetTable nodes;
+    nodes.insert(first_composition);
+    dfa.setInitialState(dfa.addState("", positions.nullable));
+    // The target of each symbol is the union of the compositions of its
+    // positions in the state, built in sets reused by every state
+    vector<StateSet> targets(symbols.size(), StateSet(count+1));
+    vector<bool> reached(symbols.size());
+    for (uint32_t id = 0; id < nodes.size(); id++) {
+        nodes.at(id).forEach([&](uint32_t position) {
+            if (position != lambda) {
+                for (uint32_t next: compositions[position]) {
+                    targets[columns[position]].insert(next);
+                }
+                reached[columns[position]] = true;
+            }
+        });
 
-    map<set<Node*>, string> nodes;
-    int i = 0;
-    nodes[first_composition] = "q" + to_string(i);
-
-    queue<set<Node*>> q;
-    q.push(first_composition);
-
-    while (!q.empty()) {
-        set<Node*> comp = q.front();
-        q.pop();
-        map<char, set<Node*>> transition;
-        for (Node *ts : comp) {
-            if (ts->getType() != LAMBDA) {
-                transition[ts->getValue()].insert(compositions[ts].begin(),
-                        compositions[ts].end());
+        for (uint32_t column = 0; column < symbols.size(); column++) {
+            if (!reached[column]) {
+                continue;
+            }
+            auto target = nodes.insert(targets[column]);
+            if (target.second) {
+                dfa.addState("", targets[column].contains(lambda));
             }
+            dfa.addTransition(id, column, target.first);
+            targets[column].clear();
+            reached[column] = false;
         }
+    }
+    dfa.compile();
+    return FiniteAutomata(classes.expand(dfa));
+}
 
-        for (auto &trs : transition) {
-            if (!nodes.count(trs.second)) {
-                i++;
-                nodes[trs.second] = "q" + to_string(i);
-                q.push(trs.second);
-                automata.addState(nodes[trs.second], (hasLambda(trs.second) ?
-                            FiniteAutomata::FINAL_STATE : 0));
-            }
-            automata.addTransition(nodes[comp], trs.first, nodes[trs.second]);
+FiniteAutomata RegularExpression::getNonDeterministicAutomata() {
+    FiniteAutomata nfa = ThompsonNFA(getSimplifiedTree()).toAutomata();
+    return FiniteAutomata(classes.expand(*nfa.getCompact()));
+}
+
+FiniteAutomata RegularExpression::getDerivativeAutomata() {
+    if (!derivatives) {
+        derivatives = make_shared<Derivatives>(getSimplifiedTree());
+    }
+    return FiniteAutomata(classes.expand(derivatives->getAutomata()));
+}
+
+bool RegularExpression::acceptsByDerivatives(string word) {
+    if (!derivatives) {
+        derivatives = make_shared<Derivatives>(getSimplifiedTree());
+    }
+    return derivatives->accepts(classes.translate(word));
+}
+
+GlushkovPositions RegularExpression::getPositions() {
+    return ExpressionDag(getSimplifiedTree()).positions();
+}
+
+bool RegularExpression::accepts(string word) {
+    if (!small_matcher && !large_matcher && !vm) {
+        // The positions are only computed when they fit in the bit-parallel
+        // matchers
+        size_t leaves = FlatTree(getSimplifiedTree()).leafCount();
+        if (leaves <= GlushkovMatcher<1>::MAX_POSITIONS) {
+            small_matcher = make_shared<GlushkovMatcher<1>>(getPositions());
+        } else if (leaves <= GlushkovMatcher<4>::MAX_POSITIONS) {
+            large_matcher = make_shared<GlushkovMatcher<4>>(getPositions());
+        } else {
+            vm = make_shared<PikeVM>(
+                    make_shared<ThompsonNFA>(getSimplifiedTree()));
         }
     }
-    return automata;
+    word = classes.translate(word);
+    if (small_matcher) {
+        return small_matcher->accepts(word);
+    } else if (large_matcher) {
+        return large_matcher->accepts(word);
+    }
+    return vm->accepts(word);
 }
 
 template<typename T>
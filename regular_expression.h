@@ -3,6 +3,39 @@
 #include "all.h"
 #include "node.h"
 #include "finite_automata.h"
+#include "glushkov_matcher.h"
+#include "thompson_nfa.h"
+#include "pike_vm.h"
+#include "flat_tree.h"
+#include "derivatives.h"
+#include "simplifier.h"
+#include "expression_dag.h"
+#include "byte_classes.h"
+#include "utf8_ranges.h"
+
+/*!
+ * Exception that is emitted when a regular expression has a syntax error
+ */
+class RegularExpressionException : public runtime_error {
+public:
+    /*!
+     * Constructs an exception for a syntax error
+     *
+     * @param message  The description of the error
+     * @param position The position of the error in the regular expression
+     */
+    RegularExpressionException(string message, size_t position);
+
+    /*!
+     * Return the position of the error in the regular expression
+     *
+     * @return The position of the error
+     */
+    size_t getPosition() const;
+
+  private:
+    size_t position; //!< The position of the error
+};
 
 /*!
  * Class used to represent a Regular Expression
@@ -12,9 +45,12 @@ class RegularExpression {
     /*!
      * Constructs a new Regular Expresion based on a string
      *
-     * @param  re The regular expression to use in the creation of the string
+     * @param  re   The regular expression to use in the creation of the string
+     * @param  utf8 If the atoms are UTF-8 code points instead of bytes: the
+     *              regular expression is decoded as UTF-8, and '.' and the
+     *              character classes match the UTF-8 encoding of a code point
      */
-    RegularExpression(string re);
+    RegularExpression(string re, bool utf8 = false);
 
     /*!
      * Get the regular expression constructed
@@ -25,13 +61,35 @@ class RegularExpression {
     string getRegularExpression();
 
     /*!
-     * Computes the De Simone tree related to this regular expression
+     * Computes the De Simone tree related to this regular expression. The
+     * tree is built once, inside an arena owned by this regular expression
+     * (and shared with its copies), so it is valid while any of them exists.
+     *
+     * @throw RegularExpressionException If the regular expression has a
+     * syntax error
      *
      * @return The root node of the De Simone tree related to this regular
      * expression
      */
     Node* getTree();
 
+    /*!
+     * Computes the De Simone tree related to this regular expression after
+     * its algebraic simplification (nested multipliers merged, repeated
+     * alternatives dropped and common prefixes and suffixes of alternatives
+     * factored). It has the same language as the tree of getTree, and it is
+     * the one used to build the automata and to match words. The tree is
+     * built once, in the same arena of the tree of getTree.
+     *
+     * @see Simplifier
+     *
+     * @throw RegularExpressionException If the regular expression has a
+     * syntax error
+     *
+     * @return The root node of the simplified De Simone tree
+     */
+    Node* getSimplifiedTree();
+
     /*!
      * Returns a deterministic (and possibly minimal) finite automata, based
      * on the De Simone tree related to this regular expression
@@ -43,138 +101,253 @@ class RegularExpression {
      */
     FiniteAutomata getAutomata();
 
+    /*!
+     * Returns a non deterministic finite automata with epsilon transitions,
+     * built by the construction of Thompson, whose size is linear in the size
+     * of this regular expression
+     *
+     * @see ThompsonNFA
+     *
+     * @return The non deterministic finite automata related to this regular
+     * expression
+     */
+    FiniteAutomata getNonDeterministicAutomata();
+
+    /*!
+     * Returns a deterministic finite automata whose states are the
+     * derivatives of Brzozowski of this regular expression
+     *
+     * @see Derivatives
+     *
+     * @return The deterministic finite automata related to this regular
+     * expression
+     */
+    FiniteAutomata getDerivativeAutomata();
+
+    /*!
+     * Check if a word is accepted by this regular expression by deriving it
+     * by each symbol of the word, without building any automata. The
+     * derivatives are kept, so later calls reuse them.
+     *
+     * @param  word The word to check
+     * @return      true if the word is accepted, false otherwise
+     */
+    bool acceptsByDerivatives(string word);
+
+    /*!
+     * Computes the positions of this regular expression (the leaves of the De
+     * Simone tree, numbered from left to right), with the positions that may
+     * be read first, last and after each position. The equal subexpressions
+     * of the simplified tree share their first and last positions.
+     *
+     * @see ExpressionDag
+     *
+     * @return The positions of this regular expression
+     */
+    GlushkovPositions getPositions();
+
+    /*!
+     * Check if a word is accepted by this regular expression. Expressions
+     * with up to 256 positions are matched by the bit-parallel simulation of
+     * their Glushkov automata, and bigger ones by the simulation of their
+     * Thompson automata, so the memory used is always linear.
+     *
+     * @param  word The word to check
+     * @return      true if the word is accepted, false otherwise
+     */
+    bool accepts(string word);
 
     /*!
-     * Check if a character is a terminal
+     * Check if a character is a terminal (a byte that stands for itself, out
+     * of a character class)
      *
      * @param  c The character to check if it is a terminal
      * @return   true if the character is a terminal, false otherwise
      */
     static bool isTerminal(char c);
 
-  private:
     /*!
-     * Compute the position of the char with the less priority (according to De
-     * Simone rules) in the regular expression passed
+     * Set the maximum number of positions of the tree (each one is a state of
+     * the Glushkov automata, besides the initial state) that the bounded
+     * repetitions may expand to. It must be set before the tree is built.
+     *
+     * The positions and the matchers take memory in proportion to the
+     * positions, but each state of the automata of getAutomata is a bitset of
+     * positions, so a repetition like [a-z]{n}, with n states, takes n*n/8
+     * bytes. The default budget keeps that around 32 MB.
      *
-     * @param  re The regular expression to analyze
-     * @return    The position of the character with less priority in the
-     * regular expression passed
+     * @param budget The maximum number of positions
      */
-    int getLessPriority(string re);
+    void setStateBudget(size_t budget);
 
+    const static size_t DEFAULT_STATE_BUDGET; //!< The default state budget
+
+  private:
     /*!
-     * Normalize the regular expression so we can identify concatenations easily
+     * Parse the regular expression, building the tree bottom up. The
+     * concatenations are implicit and a sequence of multipliers is the same
+     * multiplier when all of them are equal, or a star otherwise. Unions and
+     * concatenations are associative to the right. The bounded repetitions
+     * {m}, {m,} and {m,n} copy the repeated subtree, within the state budget.
      *
-     * @return The normalized regular expression
+     * The atoms are any symbol but the operators, an escaped symbol ('\' and
+     * the symbol, or '\x' and two hexadecimal digits), '.' for any symbol and
+     * character classes like [a-f0-9] or [^x]. The symbols are bytes, or code
+     * points in UTF-8, whose atoms become the sequences of bytes of their
+     * encodings. The byte classes are computed from the atoms in a first
+     * pass, and each set of bytes becomes the union of the representatives of
+     * its classes. The byte '&' is FiniteAutomata::EPSILON, so it is a syntax
+     * error as a symbol and it is left out of '.' and the classes, and every
+     * engine and automata reject it alike.
+     *
+     * @see ByteClasses
+     *
+     * @throw RegularExpressionException If the regular expression has a
+     * syntax error
+     *
+     * @return The tree related to the regular expression, or NULL if it is
+     * empty
      */
-    string normalize();
+    Node* parse();
 
     /*!
-     * Constructs and return the appropriate Node object for a specific
-     * character
+     * Read a symbol (a byte, or a code point in UTF-8), which may be escaped
      *
-     * @param  c    The character to create a node for
-     * @param  root The root of the node
-     * @return      The appropriate Node object for that specific character
+     * @throw RegularExpressionException If the escape is incomplete, the
+     * UTF-8 encoding is invalid or the symbol is '&'
+     *
+     * @param  i      The position of the symbol
+     * @param  symbol The symbol read
+     * @return        The position of the last byte of the symbol
      */
-    Node* getNode(char c, Node *root);
+    size_t readSymbol(size_t i, uint32_t &symbol);
 
     /*!
-     * Compute and return the appropriate tree for a regular expression
+     * Read an atom: a symbol, '.' or a character class
+     *
+     * @throw RegularExpressionException If the atom has a syntax error
      *
-     * @param  re   The regular expression to process
-     * @param  root The root of the node of the tree
-     * @return      The tree related to that regular expression
+     * @param  i      The position of the atom
+     * @param  ranges The ranges of symbols of the atom, in increasing order
+     *                and without overlaps
+     * @return        The position of the last byte of the atom
      */
-    Node* getTree(string re, Node *root);
+    size_t readAtom(size_t i, vector<pair<uint32_t, uint32_t>> &ranges);
 
     /*!
-     * Return a mapping from Node (a leaf) to a set of nodes that are reachable
-     * ascending from that leaf based on a tree.
+     * Convert the ranges of symbols of an atom to a union of sequences of
+     * sets of bytes: a single set of bytes, or the byte ranges of the UTF-8
+     * encodings of the code points (with the single bytes merged in a set)
+     *
+     * @see Utf8Ranges
      *
-     * @param  tree The tree to use to create the mapping
-     * @return      A mapping from Node (a leaf) to a set of nodes that are
-     * reachable ascending from that leaf
+     * @param  ranges The ranges of symbols of the atom
+     * @return        The sequences of sets of bytes
      */
-    map<Node*, set<Node*>> getCompositionPerLeaf(Node* tree);
+    vector<vector<StateSet>> getSequences(
+            const vector<pair<uint32_t, uint32_t>> &ranges);
 
     /*!
-     * Get the composition for the first state (in other words, the nodes that
-     * are reachable descending from the root node).
+     * Read the bounds of a bounded repetition: {m}, {m,} or {m,n}
      *
-     * @param  tree The tree to use to compute the composition of the first node
-     * @return      The composition of the first node
+     * @throw RegularExpressionException If the repetition is invalid
+     *
+     * @param  i       The position of the '{'
+     * @param  minimum The minimum number of repetitions
+     * @param  maximum The maximum number of repetitions, or SIZE_MAX if it
+     *                 is not bounded
+     * @return         The position of the '}'
      */
-    set<Node*> getFirstComposition(Node* tree);
+    size_t readRepetition(size_t i, size_t &minimum, size_t &maximum);
 
     /*!
-     * The alphabet of the Finite Automata based on the composition per leaf
-     * table
+     * Build the subtree of a bounded repetition. The mandatory copies are
+     * concatenated and the optional ones are nested, sharing their suffix:
+     * a{2,4} becomes aa(a(a)?)?, so each position is followed by at most two
+     * others instead of all the optional copies after it. A repetition
+     * without maximum ends with a '+', and {0} is the empty word (a star
+     * without child).
+     *
+     * @throw RegularExpressionException If the copies do not fit in the state
+     * budget
      *
-     * @param  leaves_comp The composition per leaf node
-     * @return             The set of characters that represent the alphabet of
-     *                     the Finite Automata
+     * @param  node     The subtree to repeat
+     * @param  minimum  The minimum number of repetitions
+     * @param  maximum  The maximum number of repetitions, or SIZE_MAX
+     * @param  position The position of the repetition
+     * @param  leaves   The number of leaves built so far, which is updated
+     * @return          The subtree of the repetition
      */
-    set<char> getAlphabet(map<Node*, set<Node*>> leaves_comp);
+    Node* repeat(Node *node, size_t minimum, size_t maximum, size_t position,
+                 size_t &leaves);
 
     /*!
-     * Return the order (according to De Simone rules) for a specific character
+     * Copy a subtree, in the arena of the tree
      *
-     * @param  c The character to compute the order
-     * @return   The order for the specified character
+     * @param  node The subtree
+     * @return      The copy of the subtree
      */
-    int getOrder(char c);
+    Node* copy(Node *node);
 
     /*!
-     * Check if a character is a multiplier
+     * Build the subtree of a sequence of alternatives, each one with a
+     * sequence of factors to concatenate
      *
-     * @param  c The character to check if it is a multiplier
-     * @return   true if the character is a multiplier, false otherwise
+     * @param  alternatives The alternatives already built
+     * @param  factors      The factors of the last alternative
+     * @param  position     The position where the sequence ends
+     * @return              The subtree of the sequence
      */
-    static bool isMultiplier(char c);
+    Node* close(vector<Node*> &alternatives, vector<Node*> &factors,
+                size_t position);
 
     /*!
-     * Check if there should be a concatenation between a character and another
+     * Join a sequence of nodes with operators associative to the right
      *
-     * @param  prev The character before the possible concatenation
-     * @param  c    The character after the possible concatenation
-     * @return      true if a concatenation should be between these two
-     *              characters, false otherwise
+     * @param  nodes     The nodes to join
+     * @param  operation The operator (a '.' or a '|')
+     * @return           The subtree that joins the nodes
      */
-    bool shouldConcatenate(char prev, char c);
+    Node* join(const vector<Node*> &nodes, char operation);
 
     /*!
-     * Check if there is Lambda node in the composition specified
+     * Constructs and return the appropriate Node object for a specific
+     * character
      *
-     * @param  composition The composition to check
-     * @return             true if there is lambda node in that composition,
-     *                     false otherwise
+     * @param  c    The character to create a node for
+     * @param  root The root of the node
+     * @return      The appropriate Node object for that specific character
      */
-    bool hasLambda(set<Node*> composition);
+    Node* getNode(char c, Node *root);
 
     /*!
-     * Given a string with multipliers, return the appropriate multiplier for
-     * that string.
+     * Check if a character is a multiplier
      *
-     * @param  multipliers A string containing only multipliers
-     * @return             A character with the appropriate multiplier for that
-     *                     string
+     * @param  c The character to check if it is a multiplier
+     * @return   true if the character is a multiplier, false otherwise
      */
-    char fixMultipliers(string multipliers);
+    static bool isMultiplier(char c);
 
     /*!
-     * Compute the leaves (may include lambda node, too) reachable in the tree
-     * given a list of NodeAction to process, while avoiding loops in the
-     * processing.
+     * Check if a character is an operator (a multiplier, a '|', a
+     * parenthesis or the '{' of a bounded repetition)
      *
-     * @param  to_process The list of NodeAction to process
-     * @return The list of leaves (or lambda, if reachable) reachables while
-     *         walking on the tree
+     * @param  c The character to check if it is an operator
+     * @return   true if the character is an operator, false otherwise
      */
-    set<Node*> getLeaves(list<NodeAction> to_process);
+    static bool isOperator(char c);
 
     string regex; //!< The regular expression specified by the user
+    bool utf8; //!< If the atoms are UTF-8 code points
+    size_t budget; //!< The maximum number of positions of the tree
+    shared_ptr<NodeArena> arena; //!< The arena that owns the nodes of the tree
+    Node *tree; //!< The tree, once it is built
+    Node *simplified; //!< The simplified tree, once it is built
+    ByteClasses classes; //!< The byte classes of the expression
+    shared_ptr<GlushkovMatcher<1>> small_matcher; //!< The matcher for up to 64 positions
+    shared_ptr<GlushkovMatcher<4>> large_matcher; //!< The matcher for up to 256 positions
+    shared_ptr<PikeVM> vm; //!< The matcher for more positions
+    shared_ptr<Derivatives> derivatives; //!< The derivatives computed so far
 };
 
 #endif  // REGULAR_EXPRESSION_H
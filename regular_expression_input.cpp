@@ -31,26 +31,12 @@ void RegularExpressionInput::fromRegularExpression(RegularExpression regex) {
 
 bool RegularExpressionInput::isValid() {
     RegularExpression input = this->toRegularExpression();
-    string regex_input = input.getRegularExpression();
-    int count_parenthesis = 0;
-
-    for (char &c : regex_input) {
-        if (c == '(') {
-            count_parenthesis++;
-        } if (c == ')') {
-            count_parenthesis--;
-        }
-
-        if (RegularExpression::isTerminal(c) && (c < '0' || c > '9') && (c < 'a' || c > 'z')) {
-            return false;
-        }
-
-        if (count_parenthesis < 0) {
-            return false;
-        }
+    try {
+        input.getTree();
+    } catch (RegularExpressionException &e) {
+        return false;
     }
-
-    return count_parenthesis == 0;
+    return true;
 }
 
 void RegularExpressionInput::matchParentheses() {
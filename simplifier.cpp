@@ -0,0 +1,294 @@
+#include "simplifier.h"
+
+Simplifier::Simplifier(NodeArena &arena): arena(arena) {
+    epsilon = make(LAMBDA, 0, vector<uint32_t>());
+}
+
+uint32_t Simplifier::make(NodeType type, char value,
+                          const vector<uint32_t> &operands) {
+    vector<uint32_t> key;
+    key.reserve(operands.size()+2);
+    key.push_back(type);
+    key.push_back((unsigned char) value);
+    key.insert(key.end(), operands.begin(), operands.end());
+    auto it = ids.find(key);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    Term term{type, value, operands, false};
+    switch (type) {
+        case LAMBDA:
+        case STAR:
+        case QUESTION:
+            term.nullable = true;
+            break;
+        case PLUS:
+            term.nullable = terms[operands[0]].nullable;
+            break;
+        case DOT:
+            term.nullable = all_of(operands.begin(), operands.end(),
+                    [&](uint32_t operand) { return terms[operand].nullable; });
+            break;
+        case UNION:
+            term.nullable = any_of(operands.begin(), operands.end(),
+                    [&](uint32_t operand) { return terms[operand].nullable; });
+            break;
+        default:
+            break;
+    }
+    uint32_t id = terms.size();
+    terms.push_back(term);
+    ids[key] = id;
+    return id;
+}
+
+vector<uint32_t> Simplifier::factors(uint32_t term) const {
+    if (terms[term].type == DOT) {
+        return terms[term].operands;
+    }
+    return vector<uint32_t>(1, term);
+}
+
+uint32_t Simplifier::sequence(const vector<uint32_t> &factors) {
+    vector<uint32_t> operands;
+    for (uint32_t factor: factors) {
+        if (terms[factor].type == DOT) {
+            const vector<uint32_t> &inner = terms[factor].operands;
+            operands.insert(operands.end(), inner.begin(), inner.end());
+        } else if (factor != epsilon) {
+            operands.push_back(factor);
+        }
+    }
+    if (operands.empty()) {
+        return epsilon;
+    }
+    if (operands.size() == 1) {
+        return operands[0];
+    }
+    return make(DOT, '.', operands);
+}
+
+uint32_t Simplifier::alternation(const vector<uint32_t> &alternatives) {
+    vector<uint32_t> operands;
+    set<uint32_t> seen;
+    bool empty_word = false;
+    for (uint32_t alternative: alternatives) {
+        vector<uint32_t> members(1, alternative);
+        if (terms[alternative].type == UNION) {
+            members = terms[alternative].operands;
+        }
+        for (uint32_t member: members) {
+            if (member == epsilon) {
+                empty_word = true;
+            } else if (seen.insert(member).second) {
+                operands.push_back(member);
+            }
+        }
+    }
+    if (operands.empty()) {
+        return epsilon;
+    }
+    operands = factor(operands, false);
+    operands = factor(operands, true);
+    uint32_t result = operands[0];
+    if (operands.size() > 1) {
+        result = make(UNION, '|', operands);
+    }
+    return empty_word ? repeat(QUESTION, result) : result;
+}
+
+vector<uint32_t> Simplifier::factor(const vector<uint32_t> &alternatives,
+                                    bool last) {
+    if (alternatives.size() < 2) {
+        return alternatives;
+    }
+    // The alternatives are grouped by their first (or last) factor, and each
+    // group takes the place of its first alternative
+    vector<uint32_t> heads;
+    map<uint32_t, vector<vector<uint32_t>>> groups;
+    for (uint32_t alternative: alternatives) {
+        vector<uint32_t> chain = factors(alternative);
+        if (last) {
+            reverse(chain.begin(), chain.end());
+        }
+        auto &group = groups[chain[0]];
+        if (group.empty()) {
+            heads.push_back(chain[0]);
+        }
+        group.push_back(chain);
+    }
+    if (heads.size() == alternatives.size()) {
+        return alternatives;
+    }
+    vector<uint32_t> result;
+    for (uint32_t head: heads) {
+        vector<vector<uint32_t>> &group = groups[head];
+        // The longest common prefix is taken at once, so a long prefix does
+        // not nest one union per factor
+        size_t common = group[0].size();
+        for (const vector<uint32_t> &chain: group) {
+            size_t length = 0;
+            while (length < common && length < chain.size() &&
+                    chain[length] == group[0][length]) {
+                length++;
+            }
+            common = length;
+        }
+        vector<uint32_t> rests;
+        for (const vector<uint32_t> &chain: group) {
+            vector<uint32_t> rest(chain.begin()+common, chain.end());
+            if (last) {
+                reverse(rest.begin(), rest.end());
+            }
+            rests.push_back(sequence(rest));
+        }
+        vector<uint32_t> shared(group[0].begin(), group[0].begin()+common);
+        uint32_t inner = group.size() > 1 ? alternation(rests) : rests[0];
+        if (last) {
+            reverse(shared.begin(), shared.end());
+            shared.insert(shared.begin(), inner);
+        } else {
+            shared.push_back(inner);
+        }
+        result.push_back(sequence(shared));
+    }
+    return result;
+}
+
+uint32_t Simplifier::repeat(NodeType type, uint32_t operand) {
+    if (operand == epsilon) {
+        return epsilon;
+    }
+    NodeType inner = terms[operand].type;
+    if (inner == type) {
+        return operand;
+    }
+    // Two different multipliers are the same as a star
+    if (inner == STAR || inner == PLUS || inner == QUESTION) {
+        return make(STAR, '*', terms[operand].operands);
+    }
+    if (terms[operand].nullable && type == QUESTION) {
+        return operand;
+    }
+    if (terms[operand].nullable && type == PLUS) {
+        type = STAR;
+    }
+    char value = type == STAR ? '*' : (type == PLUS ? '+' : '?');
+    return make(type, value, vector<uint32_t>(1, operand));
+}
+
+Node* Simplifier::simplify(Node *tree) {
+    if (tree->getType() == LAMBDA) {
+        tree = tree->getLeft();
+    }
+    if (!tree) {
+        return NULL;
+    }
+    // Each chain of concatenations or unions is a single frame, so a long
+    // chain is flattened once instead of once per node
+    struct Frame {
+        Node *node;
+        vector<Node*> children;
+        vector<uint32_t> operands;
+    };
+    vector<Frame> frames;
+    uint32_t result = epsilon;
+    Node *next = tree;
+    while (true) {
+        if (next) {
+            NodeType type = next->getType();
+            if (type == LEAF) {
+                result = make(LEAF, next->getValue(), vector<uint32_t>());
+            } else {
+                Frame frame{next, vector<Node*>(), vector<uint32_t>()};
+                Node *node = next;
+                while (node && node->getType() == type &&
+                        (type == DOT || type == UNION)) {
+                    frame.children.push_back(node->getLeft());
+                    node = node->getRight();
+                }
+                frame.children.push_back(type == DOT || type == UNION ?
+                        node : next->getLeft());
+                frames.push_back(frame);
+                next = frames.back().children[0];
+                continue;
+            }
+        } else {
+            // A missing child is the empty word
+            result = epsilon;
+        }
+        // The term of a child is done, so it goes to its frame
+        while (!frames.empty()) {
+            Frame &frame = frames.back();
+            frame.operands.push_back(result);
+            if (frame.operands.size() < frame.children.size()) {
+                break;
+            }
+            NodeType type = frame.node->getType();
+            if (type == DOT) {
+                result = sequence(frame.operands);
+            } else if (type == UNION) {
+                result = alternation(frame.operands);
+            } else {
+                result = repeat(type, frame.operands[0]);
+            }
+            frames.pop_back();
+        }
+        if (frames.empty()) {
+            break;
+        }
+        next = frames.back().children[frames.back().operands.size()];
+    }
+    return emit(result);
+}
+
+Node* Simplifier::emit(uint32_t term) {
+    const Term &current = terms[term];
+    switch (current.type) {
+        case LEAF:
+            return arena.create<LeafNode>(current.value, 0);
+        case DOT:
+        case UNION: {
+            vector<Node*> nodes;
+            for (uint32_t operand: current.operands) {
+                nodes.push_back(emit(operand));
+            }
+            return join(nodes, current.type);
+        }
+        default:
+            break;
+    }
+    // The empty word is a star without a child, like a missing child
+    Node *node;
+    if (current.type == PLUS) {
+        node = arena.create<PlusNode>('+', 0);
+    } else if (current.type == QUESTION) {
+        node = arena.create<QuestionMarkNode>('?', 0);
+    } else {
+        node = arena.create<StarNode>('*', 0);
+    }
+    if (!current.operands.empty()) {
+        Node *child = emit(current.operands[0]);
+        node->setLeft(child);
+        child->setRoot(node);
+    }
+    return node;
+}
+
+Node* Simplifier::join(const vector<Node*> &nodes, NodeType operation) {
+    Node *tree = nodes.back();
+    for (size_t i = nodes.size()-1; i-- > 0;) {
+        Node *node;
+        if (operation == DOT) {
+            node = arena.create<DotNode>('.', 0);
+        } else {
+            node = arena.create<UnionNode>('|', 0);
+        }
+        node->setLeft(nodes[i]);
+        node->setRight(tree);
+        nodes[i]->setRoot(node);
+        tree->setRoot(node);
+        tree = node;
+    }
+    return tree;
+}
@@ -0,0 +1,134 @@
+#ifndef SIMPLIFIER_H
+#define SIMPLIFIER_H
+
+#include "all.h"
+#include "node.h"
+
+/*!
+ * This class rewrites a De Simone tree into a smaller tree with the same
+ * language, so the automata built from it have fewer positions to explore.
+ *
+ * The tree is first converted (bottom up) to hash-consed terms where
+ * concatenations and unions are flat sequences, so equal subtrees have the
+ * same ID. While the terms are built these rules are applied:
+ *
+ * - the empty word is dropped from concatenations (ε·r = r);
+ * - repeated alternatives are dropped (r|r = r), and an alternative that is
+ *   the empty word makes the union optional (r|ε = r?);
+ * - nested multipliers are merged ((r*)* = r*, (r?)* = r*, (r+)? = r*, ...),
+ *   and an optional expression that already accepts the empty word is kept
+ *   as it is;
+ * - alternatives with the same first (or last) factor are factored
+ *   (ab|ac = a(b|c), ac|bc = (a|b)c, a|ab = ab?).
+ *
+ * The terms are then converted back to a tree, allocated in an arena.
+ */
+class Simplifier {
+public:
+    /*!
+     * Constructs a simplifier that allocates the new trees in an arena
+     *
+     * @param arena The arena that owns the new trees
+     */
+    explicit Simplifier(NodeArena &arena);
+
+    /*!
+     * Simplify a tree
+     *
+     * @param tree The tree (or the lambda node alone for the empty language)
+     * @return The top node of the simplified tree (without a father), or
+     *         NULL if the tree is empty
+     */
+    Node* simplify(Node *tree);
+
+private:
+    /*!
+     * A term: a leaf, a sequence (DOT) or a union (UNION) of terms, a
+     * multiplier of a term or the empty word (LAMBDA)
+     */
+    struct Term {
+        NodeType type; //!< The type of the term
+        char value; //!< The value of a leaf
+        vector<uint32_t> operands; //!< The operands of the term
+        bool nullable; //!< If the term accepts the empty word
+    };
+
+    /*!
+     * Return the ID of a term, adding it if it was not built yet
+     *
+     * @param type     The type of the term
+     * @param value    The value of a leaf
+     * @param operands The operands of the term
+     * @return The ID of the term
+     */
+    uint32_t make(NodeType type, char value, const vector<uint32_t> &operands);
+
+    /*!
+     * Build the concatenation of some terms, flattening the sequences and
+     * dropping the empty word
+     *
+     * @param factors The terms to concatenate
+     * @return The ID of the term
+     */
+    uint32_t sequence(const vector<uint32_t> &factors);
+
+    /*!
+     * Build the union of some terms, flattening the unions, dropping the
+     * repeated ones and factoring the common first and last factors
+     *
+     * @param alternatives The terms to unite
+     * @return The ID of the term
+     */
+    uint32_t alternation(const vector<uint32_t> &alternatives);
+
+    /*!
+     * Build a multiplier of a term, merging nested multipliers
+     *
+     * @param type    The multiplier (STAR, PLUS or QUESTION)
+     * @param operand The term
+     * @return The ID of the term
+     */
+    uint32_t repeat(NodeType type, uint32_t operand);
+
+    /*!
+     * Factor the longest common prefix (or suffix) of the alternatives that
+     * share their first (or last) factor
+     *
+     * @param alternatives The alternatives, without repetitions
+     * @param last         true to factor the last factors, false for the
+     *                     first ones
+     * @return The alternatives after the factoring
+     */
+    vector<uint32_t> factor(const vector<uint32_t> &alternatives, bool last);
+
+    /*!
+     * Return the factors of a term (the term itself if it is not a sequence)
+     *
+     * @param term The term
+     * @return The factors of the term
+     */
+    vector<uint32_t> factors(uint32_t term) const;
+
+    /*!
+     * Build the tree of a term
+     *
+     * @param term The term
+     * @return The top node of the tree
+     */
+    Node* emit(uint32_t term);
+
+    /*!
+     * Join some nodes with operators associative to the right
+     *
+     * @param nodes     The nodes to join
+     * @param operation The operator (DOT or UNION)
+     * @return The top node of the tree
+     */
+    Node* join(const vector<Node*> &nodes, NodeType operation);
+
+    NodeArena &arena; //!< The arena that owns the new trees
+    vector<Term> terms; //!< The terms, indexed by ID
+    map<vector<uint32_t>, uint32_t> ids; //!< The IDs of the terms, by type, value and operands
+    uint32_t epsilon; //!< The ID of the empty word
+};
+#endif // SIMPLIFIER_H
@@ -0,0 +1,261 @@
+#include "state_set.h"
+
+StateSet::StateSet(): size(0), hash_value(0) {}
+
+StateSet::StateSet(uint32_t capacity): bits((capacity+63)/64, 0),
+    size(capacity), hash_value(0) {}
+
+uint64_t StateSet::mix(uint64_t state) {
+    // Finalizer of splitmix64
+    state += 0x9e3779b97f4a7c15ULL;
+    state = (state ^ (state >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    state = (state ^ (state >> 27)) * 0x94d049bb133111ebULL;
+    return state ^ (state >> 31);
+}
+
+bool StateSet::insert(uint32_t state) {
+    uint64_t mask = 1ULL << (state % 64);
+    uint64_t &word = bits[state/64];
+    if (word & mask) {
+        return false;
+    }
+    word |= mask;
+    hash_value += mix(state);
+    return true;
+}
+
+bool StateSet::erase(uint32_t state) {
+    uint64_t mask = 1ULL << (state % 64);
+    uint64_t &word = bits[state/64];
+    if (!(word & mask)) {
+        return false;
+    }
+    word &= ~mask;
+    hash_value -= mix(state);
+    return true;
+}
+
+bool StateSet::contains(uint32_t state) const {
+    return (bits[state/64] >> (state % 64)) & 1;
+}
+
+bool StateSet::unite(const StateSet &other) {
+    bool changed = false;
+    for (size_t word = 0; word < bits.size(); word++) {
+        uint64_t added = other.bits[word] & ~bits[word];
+        if (!added) {
+            continue;
+        }
+        changed = true;
+        bits[word] |= added;
+        while (added) {
+            hash_value += mix(word*64+__builtin_ctzll(added));
+            added &= added-1;
+        }
+    }
+    return changed;
+}
+
+void StateSet::intersect(const StateSet &other) {
+    for (size_t word = 0; word < bits.size(); word++) {
+        uint64_t removed = bits[word] & ~other.bits[word];
+        if (!removed) {
+            continue;
+        }
+        bits[word] &= ~removed;
+        while (removed) {
+            hash_value -= mix(word*64+__builtin_ctzll(removed));
+            removed &= removed-1;
+        }
+    }
+}
+
+bool StateSet::intersects(const StateSet &other) const {
+    for (size_t word = 0; word < bits.size(); word++) {
+        if (bits[word] & other.bits[word]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StateSet::isSubsetOf(const StateSet &other) const {
+    for (size_t word = 0; word < bits.size(); word++) {
+        if (bits[word] & ~other.bits[word]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StateSet::clear() {
+    fill(bits.begin(), bits.end(), 0);
+    hash_value = 0;
+}
+
+bool StateSet::empty() const {
+    for (uint64_t word: bits) {
+        if (word) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t StateSet::count() const {
+    uint32_t result = 0;
+    for (uint64_t word: bits) {
+        result += __builtin_popcountll(word);
+    }
+    return result;
+}
+
+uint32_t StateSet::capacity() const {
+    return size;
+}
+
+uint64_t StateSet::hash() const {
+    return hash_value;
+}
+
+vector<uint32_t> StateSet::elements() const {
+    vector<uint32_t> result;
+    forEach([&result](uint32_t state) {
+        result.push_back(state);
+    });
+    return result;
+}
+
+bool StateSet::operator==(const StateSet &other) const {
+    return hash_value == other.hash_value && bits == other.bits;
+}
+
+bool StateSet::operator!=(const StateSet &other) const {
+    return !(*this == other);
+}
+
+bool StateSet::operator<(const StateSet &other) const {
+    return bits < other.bits;
+}
+
+const uint32_t StateSetTable::NOT_FOUND = UINT32_MAX;
+
+StateSetTable::StateSetTable(): slots(16, NOT_FOUND) {}
+
+size_t StateSetTable::findSlot(const StateSet &set) const {
+    size_t mask = slots.size()-1;
+    size_t slot = set.hash() & mask;
+    while (slots[slot] != NOT_FOUND && sets[slots[slot]] != set) {
+        slot = (slot+1) & mask;
+    }
+    return slot;
+}
+
+void StateSetTable::grow() {
+    slots.assign(slots.size()*2, NOT_FOUND);
+    for (uint32_t id = 0; id < sets.size(); id++) {
+        slots[findSlot(sets[id])] = id;
+    }
+}
+
+pair<uint32_t, bool> StateSetTable::insert(const StateSet &set) {
+    size_t slot = findSlot(set);
+    if (slots[slot] != NOT_FOUND) {
+        return make_pair(slots[slot], false);
+    }
+    uint32_t id = sets.size();
+    sets.push_back(set);
+    slots[slot] = id;
+    // Keep the load factor below 1/2
+    if (sets.size()*2 > slots.size()) {
+        grow();
+    }
+    return make_pair(id, true);
+}
+
+uint32_t StateSetTable::find(const StateSet &set) const {
+    return slots[findSlot(set)];
+}
+
+const StateSet &StateSetTable::at(uint32_t id) const {
+    return sets[id];
+}
+
+uint32_t StateSetTable::size() const {
+    return sets.size();
+}
+
+void StateSetTable::clear() {
+    sets.clear();
+    slots.assign(16, NOT_FOUND);
+}
+
+const uint32_t ConcurrentStateSetTable::NOT_FOUND = UINT32_MAX;
+
+ConcurrentStateSetTable::ConcurrentStateSetTable(uint32_t shards):
+    shards(shards) {
+    for (Shard &shard: this->shards) {
+        shard.slots.assign(16, nullptr);
+    }
+}
+
+ConcurrentStateSetTable::Entry *ConcurrentStateSetTable::insert(
+        const StateSet &set) {
+    // The high bits choose the shard and the low bits choose the slot
+    uint64_t hash = set.hash();
+    Shard &shard = shards[(hash >> 32) & (shards.size()-1)];
+    lock_guard<mutex> guard(shard.lock);
+    size_t mask = shard.slots.size()-1;
+    size_t slot = hash & mask;
+    while (shard.slots[slot] && shard.slots[slot]->set != set) {
+        slot = (slot+1) & mask;
+    }
+    if (shard.slots[slot]) {
+        return shard.slots[slot];
+    }
+    shard.entries.push_back(Entry{set, NOT_FOUND});
+    Entry *entry = &shard.entries.back();
+    shard.slots[slot] = entry;
+    // Keep the load factor below 1/2
+    if (shard.entries.size()*2 > shard.slots.size()) {
+        shard.slots.assign(shard.slots.size()*2, nullptr);
+        mask = shard.slots.size()-1;
+        for (Entry &other: shard.entries) {
+            slot = other.set.hash() & mask;
+            while (shard.slots[slot]) {
+                slot = (slot+1) & mask;
+            }
+            shard.slots[slot] = &other;
+        }
+    }
+    return entry;
+}
+
+SparseSet::SparseSet(uint32_t capacity): dense(capacity), sparse(capacity),
+    size(0) {}
+
+bool SparseSet::insert(uint32_t state) {
+    if (contains(state)) {
+        return false;
+    }
+    sparse[state] = size;
+    dense[size++] = state;
+    return true;
+}
+
+bool SparseSet::contains(uint32_t state) const {
+    uint32_t index = sparse[state];
+    return index < size && dense[index] == state;
+}
+
+void SparseSet::clear() {
+    size = 0;
+}
+
+uint32_t SparseSet::count() const {
+    return size;
+}
+
+uint32_t SparseSet::at(uint32_t index) const {
+    return dense[index];
+}
@@ -0,0 +1,338 @@
+#ifndef STATE_SET_H
+#define STATE_SET_H
+
+#include "all.h"
+
+/*!
+ * A set of state IDs represented as a dense bitset.
+ *
+ * The operations between sets work word by word (so they are simple loops
+ * that the compiler can vectorize) and the hash of the set is kept up to date
+ * incrementally: it is the sum of a mixed value of each element, so adding an
+ * element only needs to add the mixed value of that element.
+ */
+class StateSet {
+public:
+    /*!
+     * Constructs an empty set that can not receive any element
+     */
+    StateSet();
+
+    /*!
+     * Constructs an empty set that can receive elements between 0 and
+     * capacity-1
+     *
+     * @param capacity The number of elements that this set can represent
+     */
+    explicit StateSet(uint32_t capacity);
+
+    /*!
+     * Add an element to the set
+     *
+     * @param state The element to add
+     * @return true if the element was not in the set, false otherwise
+     */
+    bool insert(uint32_t state);
+
+    /*!
+     * Remove an element from the set
+     *
+     * @param state The element to remove
+     * @return true if the element was in the set, false otherwise
+     */
+    bool erase(uint32_t state);
+
+    /*!
+     * Check if an element is in the set
+     *
+     * @param state The element to check
+     * @return true if the element is in the set, false otherwise
+     */
+    bool contains(uint32_t state) const;
+
+    /*!
+     * Add all the elements of another set (with the same capacity) to this set
+     *
+     * @param other The set with the elements to add
+     * @return true if some element was added, false otherwise
+     */
+    bool unite(const StateSet &other);
+
+    /*!
+     * Remove all the elements that are not in another set (with the same
+     * capacity)
+     *
+     * @param other The set with the elements to keep
+     */
+    void intersect(const StateSet &other);
+
+    /*!
+     * Check if this set has some element in common with another set (with the
+     * same capacity)
+     *
+     * @param other The set to compare
+     * @return true if both sets share an element, false otherwise
+     */
+    bool intersects(const StateSet &other) const;
+
+    /*!
+     * Check if all the elements of this set are in another set (with the same
+     * capacity)
+     *
+     * @param other The set to compare
+     * @return true if this set is a subset of the other set, false otherwise
+     */
+    bool isSubsetOf(const StateSet &other) const;
+
+    /*!
+     * Remove all the elements of the set
+     */
+    void clear();
+
+    /*!
+     * Check if the set is empty
+     *
+     * @return true if the set does not have any element, false otherwise
+     */
+    bool empty() const;
+
+    /*!
+     * Return the number of elements in the set
+     */
+    uint32_t count() const;
+
+    /*!
+     * Return the number of elements that this set can represent
+     */
+    uint32_t capacity() const;
+
+    /*!
+     * Return the hash of this set, which only depends on its elements
+     */
+    uint64_t hash() const;
+
+    /*!
+     * Return the elements of this set, in ascending order
+     */
+    vector<uint32_t> elements() const;
+
+    /*!
+     * Call a function for each element of the set, in ascending order
+     *
+     * @param function The function to call with each element
+     */
+    template <typename Function>
+    void forEach(Function function) const {
+        for (size_t word = 0; word < bits.size(); word++) {
+            uint64_t value = bits[word];
+            while (value) {
+                uint32_t bit = __builtin_ctzll(value);
+                function((uint32_t) (word*64+bit));
+                value &= value-1;
+            }
+        }
+    }
+
+    /*!
+     * Check if two sets have the same elements
+     */
+    bool operator==(const StateSet &other) const;
+
+    /*!
+     * Check if two sets do not have the same elements
+     */
+    bool operator!=(const StateSet &other) const;
+
+    /*!
+     * Order the sets by their words, so they can be used as keys of a map
+     */
+    bool operator<(const StateSet &other) const;
+
+private:
+    /*!
+     * Mix the bits of an element to compute its contribution to the hash
+     *
+     * @param state The element to mix
+     * @return The contribution of that element to the hash of the set
+     */
+    static uint64_t mix(uint64_t state);
+
+    vector<uint64_t> bits; //!< The words of the bitset
+    uint32_t size; //!< The capacity of the set
+    uint64_t hash_value; //!< The incremental hash of the set
+};
+
+/*!
+ * A hash table that interns StateSet objects, giving dense IDs to them (in
+ * the order in which they were inserted). It uses open addressing with linear
+ * probing, so looking up a set only compares the sets with the same hash.
+ */
+class StateSetTable {
+public:
+    /*!
+     * Constructs an empty table
+     */
+    StateSetTable();
+
+    /*!
+     * Insert a set in the table, if it is not there yet
+     *
+     * @param set The set to insert
+     * @return A pair with the ID of the set and true if the set was
+     *         inserted now, false if it was already in the table
+     */
+    pair<uint32_t, bool> insert(const StateSet &set);
+
+    /*!
+     * Return the ID of a set
+     *
+     * @param set The set to search
+     * @return The ID of the set or NOT_FOUND if the set is not in the table
+     */
+    uint32_t find(const StateSet &set) const;
+
+    /*!
+     * Return the set with a specific ID
+     *
+     * @param id The ID of the set
+     * @return The set with that ID
+     */
+    const StateSet &at(uint32_t id) const;
+
+    /*!
+     * Return the number of sets in the table
+     */
+    uint32_t size() const;
+
+    /*!
+     * Remove all the sets from the table, so the IDs start from 0 again
+     */
+    void clear();
+
+    const static uint32_t NOT_FOUND; //!< Returned when a set is not found
+private:
+    /*!
+     * Return the slot where a set is (or should be) stored
+     *
+     * @param set The set to search
+     * @return The index of the slot
+     */
+    size_t findSlot(const StateSet &set) const;
+
+    /*!
+     * Double the number of slots of the table, rehashing all the sets
+     */
+    void grow();
+
+    vector<StateSet> sets; //!< The sets of the table, indexed by ID
+    vector<uint32_t> slots; //!< The ID of the set in each slot
+};
+
+/*!
+ * A hash table that interns StateSet objects and that can be used by many
+ * threads at the same time. The sets are spread over shards by their hash,
+ * each one with its own lock and its own open addressing table, so threads
+ * only wait for each other when they insert sets in the same shard.
+ *
+ * Each set has an ID that is not given by the table: it starts as NOT_FOUND
+ * and it is set by the owner of the table, which may number the sets in a
+ * deterministic order after they are inserted by the threads. The entries are
+ * never moved, so their addresses stay valid while the table exists.
+ */
+class ConcurrentStateSetTable {
+public:
+    /*!
+     * An interned set and its ID
+     */
+    struct Entry {
+        StateSet set; //!< The set
+        uint32_t id; //!< The ID of the set, or NOT_FOUND if it was not set
+    };
+
+    /*!
+     * Constructs an empty table
+     *
+     * @param shards The number of shards (a power of 2)
+     */
+    explicit ConcurrentStateSetTable(uint32_t shards = 64);
+
+    /*!
+     * Insert a set in the table, if it is not there yet. It may be called by
+     * many threads at the same time.
+     *
+     * @param set The set to insert
+     * @return The entry of the set, whose ID is NOT_FOUND if it was inserted
+     *         now and no ID was set since then
+     */
+    Entry *insert(const StateSet &set);
+
+    const static uint32_t NOT_FOUND; //!< The ID of a set that has no ID yet
+private:
+    /*!
+     * A part of the table, with the sets whose hash falls in it
+     */
+    struct Shard {
+        mutex lock; //!< Guards the shard
+        deque<Entry> entries; //!< The entries, in the order of insertion
+        vector<Entry*> slots; //!< The entry in each slot
+    };
+
+    vector<Shard> shards; //!< The shards of the table
+};
+
+/*!
+ * A set of state IDs represented as a sparse set (from Briggs and Torczon):
+ * a dense array with the elements in insertion order and a sparse array with
+ * the position of each element in the dense array. Inserting, looking up and
+ * clearing the set are all O(1), and iterating over it follows the order of
+ * insertion, without touching the states that are not in the set.
+ */
+class SparseSet {
+public:
+    /*!
+     * Constructs an empty set that can receive elements between 0 and
+     * capacity-1
+     *
+     * @param capacity The number of elements that this set can represent
+     */
+    explicit SparseSet(uint32_t capacity = 0);
+
+    /*!
+     * Add an element to the set
+     *
+     * @param state The element to add
+     * @return true if the element was not in the set, false otherwise
+     */
+    bool insert(uint32_t state);
+
+    /*!
+     * Check if an element is in the set
+     *
+     * @param state The element to check
+     * @return true if the element is in the set, false otherwise
+     */
+    bool contains(uint32_t state) const;
+
+    /*!
+     * Remove all the elements from the set
+     */
+    void clear();
+
+    /*!
+     * Return the number of elements in the set
+     */
+    uint32_t count() const;
+
+    /*!
+     * Return the element at a position of the insertion order
+     *
+     * @param index The position, between 0 and count()-1
+     * @return The element at that position
+     */
+    uint32_t at(uint32_t index) const;
+private:
+    vector<uint32_t> dense; //!< The elements, in insertion order
+    vector<uint32_t> sparse; //!< The position of each element in dense
+    uint32_t size; //!< The number of elements in the set
+};
+#endif // STATE_SET_H
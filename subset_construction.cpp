@@ -0,0 +1,165 @@
+#include "subset_construction.h"
+
+SubsetConstruction::SubsetConstruction(const CompactAutomata &nfa,
+                                       shared_ptr<const EpsilonClosure> closure):
+    nfa(nfa), closure(closure), final_states(nfa.size()), names(false),
+    threads(1) {
+    if (!this->closure) {
+        this->closure = make_shared<EpsilonClosure>(nfa);
+    }
+    for (uint32_t state = 0; state < nfa.size(); state++) {
+        if (nfa.isFinalState(state)) {
+            final_states.insert(state);
+        }
+    }
+}
+
+void SubsetConstruction::setNames(bool names) {
+    this->names = names;
+}
+
+void SubsetConstruction::step(const StateSet &states, uint32_t column,
+                              StateSet &result) const {
+    result.clear();
+    states.forEach([&](uint32_t state) {
+        for (uint32_t target: nfa.successors(state, column)) {
+            // The result is a union of closures, so a target already there
+            // has its closure there too
+            if (result.contains(target)) {
+                continue;
+            }
+            for (uint32_t reached: closure->closure(target)) {
+                result.insert(reached);
+            }
+        }
+    });
+}
+
+StateSet SubsetConstruction::initialStates() const {
+    StateSet result(nfa.size());
+    for (uint32_t reached: closure->closure(nfa.initialState())) {
+        result.insert(reached);
+    }
+    return result;
+}
+
+bool SubsetConstruction::isFinal(const StateSet &states) const {
+    return states.intersects(final_states);
+}
+
+void SubsetConstruction::setThreads(unsigned threads) {
+    this->threads = threads;
+}
+
+string SubsetConstruction::formatStates(const StateSet &states) const {
+    vector<string> stateNames;
+    states.forEach([&](uint32_t state) {
+        stateNames.push_back(nfa.stateName(state));
+    });
+    sort(stateNames.begin(), stateNames.end());
+    string s = "[";
+    for (size_t i = 0; i < stateNames.size(); i++) {
+        if (i > 0) {
+            s.append(",");
+        }
+        s.append(stateNames[i]);
+    }
+    s.append("]");
+    return s;
+}
+
+CompactAutomata SubsetConstruction::determinize() const {
+    if (ThreadPool::resolve(threads) > 1) {
+        ThreadPool pool(threads);
+        return determinize(pool);
+    }
+    CompactAutomata result;
+    for (uint32_t column = 0; column < nfa.symbolCount(); column++) {
+        result.addSymbol(nfa.symbolAt(column));
+    }
+    StateSetTable table;
+    StateSet initial = initialStates();
+    table.insert(initial);
+    result.addState("", isFinal(initial));
+    result.setInitialState(0);
+    StateSet next(nfa.size());
+    // The table gives IDs in the order of discovery, so it is also the queue
+    // of the breadth-first search
+    for (uint32_t id = 0; id < table.size(); id++) {
+        for (uint32_t column = 0; column < nfa.symbolCount(); column++) {
+            step(table.at(id), column, next);
+            if (next.empty()) {
+                continue;
+            }
+            pair<uint32_t, bool> inserted = table.insert(next);
+            if (inserted.second) {
+                result.addState("", isFinal(next));
+            }
+            result.addTransition(id, column, inserted.first);
+        }
+    }
+    if (names) {
+        for (uint32_t id = 0; id < table.size(); id++) {
+            result.setStateName(id, formatStates(table.at(id)));
+        }
+    }
+    result.compile();
+    return result;
+}
+
+CompactAutomata SubsetConstruction::determinize(ThreadPool &pool) const {
+    const size_t CHUNK = 64;
+    uint32_t columns = nfa.symbolCount();
+    CompactAutomata result;
+    for (uint32_t column = 0; column < columns; column++) {
+        result.addSymbol(nfa.symbolAt(column));
+    }
+    ConcurrentStateSetTable table;
+    ConcurrentStateSetTable::Entry *initial = table.insert(initialStates());
+    initial->id = 0;
+    result.addState("", isFinal(initial->set));
+    result.setInitialState(0);
+    // The sets by ID; the sets of the current level are the last ones
+    vector<const StateSet*> sets(1, &initial->set);
+    vector<StateSet> buffers(pool.size(), StateSet(nfa.size()));
+    vector<ConcurrentStateSetTable::Entry*> targets;
+    for (uint32_t level = 0; level < sets.size();) {
+        uint32_t end = sets.size();
+        targets.assign((size_t) (end-level)*columns, nullptr);
+        pool.run((end-level+CHUNK-1)/CHUNK, [&](size_t chunk, unsigned worker) {
+            StateSet &next = buffers[worker];
+            uint32_t last = min<size_t>(level+(chunk+1)*CHUNK, end);
+            for (uint32_t id = level+chunk*CHUNK; id < last; id++) {
+                for (uint32_t column = 0; column < columns; column++) {
+                    step(*sets[id], column, next);
+                    if (!next.empty()) {
+                        targets[(size_t) (id-level)*columns+column] =
+                                table.insert(next);
+                    }
+                }
+            }
+        });
+        // The new sets are numbered in the same order of the sequential
+        // search, which is the order of their first transition
+        for (size_t index = 0; index < targets.size(); index++) {
+            ConcurrentStateSetTable::Entry *target = targets[index];
+            if (!target) {
+                continue;
+            }
+            if (target->id == ConcurrentStateSetTable::NOT_FOUND) {
+                target->id = sets.size();
+                sets.push_back(&target->set);
+                result.addState("", isFinal(target->set));
+            }
+            result.addTransition(level+index/columns, index%columns, target->id);
+        }
+        level = end;
+    }
+    if (names) {
+        for (uint32_t id = 0; id < sets.size(); id++) {
+            result.setStateName(id, formatStates(*sets[id]));
+        }
+    }
+    result.compile();
+    return result;
+}
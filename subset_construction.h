@@ -0,0 +1,115 @@
+#ifndef SUBSET_CONSTRUCTION_H
+#define SUBSET_CONSTRUCTION_H
+
+#include "all.h"
+#include "compact_automata.h"
+#include "state_set.h"
+#include "epsilon_closure.h"
+#include "thread_pool.h"
+
+/*!
+ * This class implements the subset construction, which converts a
+ * (possibly non deterministic, with epsilon transitions) compact automata into
+ * a deterministic one.
+ *
+ * The sets of states of the non deterministic automata are represented as
+ * bitsets and deduplicated through a StateSetTable, so no names are built
+ * while the automata is explored. The names (in the format "[q0,q1]") are
+ * only computed at the end, and only if they are requested.
+ *
+ * The epsilon closures come from an EpsilonClosure, so each closure is
+ * computed once, and not once per step.
+ *
+ * With more than one thread, the search goes level by level: the steps of
+ * the sets of a level are computed by all the threads and interned in a
+ * ConcurrentStateSetTable, and then the new sets are numbered in the order
+ * of their first transition, so the result is the same for any number of
+ * threads.
+ */
+class SubsetConstruction {
+public:
+    /*!
+     * Constructs a subset construction over a compiled compact automata
+     *
+     * @param nfa     The automata to determinize, which must have an initial
+     *                state
+     * @param closure The epsilon closures of the automata, which are computed
+     *                if they are not passed
+     */
+    explicit SubsetConstruction(const CompactAutomata &nfa,
+                                shared_ptr<const EpsilonClosure> closure = nullptr);
+
+    /*!
+     * Define if the states of the resulting automata should be named after
+     * the sets of states that they represent. By default, they are anonymous.
+     *
+     * @param names true to name the states, false otherwise
+     */
+    void setNames(bool names);
+
+    /*!
+     * Define the number of threads used by the construction. By default, it
+     * uses a single thread.
+     *
+     * @param threads The number of threads, or 0 to use one per core
+     */
+    void setThreads(unsigned threads);
+
+    /*!
+     * Run the subset construction, returning a compiled deterministic automata
+     * with only the reachable states. The initial state always has the ID 0.
+     *
+     * @return The deterministic automata
+     */
+    CompactAutomata determinize() const;
+
+    /*!
+     * Return the name of a set of states of the automata, in the same format
+     * of FiniteAutomata::formatStates
+     *
+     * @param states The set of states
+     * @return The name of that set of states
+     */
+    string formatStates(const StateSet &states) const;
+
+protected:
+    /*!
+     * Compute the set of states reachable from a set of states by a symbol
+     * column, including the epsilon closure of these states
+     *
+     * @param states The source set of states
+     * @param column The column of the symbol
+     * @param result The set where the result is stored (it is cleared first)
+     */
+    void step(const StateSet &states, uint32_t column, StateSet &result) const;
+
+    /*!
+     * Compute the epsilon closure of the initial state
+     *
+     * @return The set of states of the initial state of the result
+     */
+    StateSet initialStates() const;
+
+    /*!
+     * Check if a set of states has a final state
+     *
+     * @param states The set of states to check
+     * @return true if some of the states is final, false otherwise
+     */
+    bool isFinal(const StateSet &states) const;
+
+    /*!
+     * Run the subset construction level by level, on a pool of threads
+     *
+     * @param pool The threads
+     * @return The deterministic automata, the same of the sequential search
+     */
+    CompactAutomata determinize(ThreadPool &pool) const;
+
+    const CompactAutomata &nfa; //!< The automata being determinized
+    shared_ptr<const EpsilonClosure> closure; //!< The epsilon closures of the automata
+    StateSet final_states; //!< The final states of the automata, as a bitset
+    bool names; //!< If the states of the result should have names
+    unsigned threads; //!< The number of threads (0 for one per core)
+};
+#endif // SUBSET_CONSTRUCTION_H
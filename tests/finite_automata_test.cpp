@@ -1,4 +1,14 @@
 #include <gtest/gtest.h>
+#include "compact_automata.cpp"
+#include "state_set.cpp"
+#include "epsilon_closure.cpp"
+#include "lazy_dfa.cpp"
+#include "subset_construction.cpp"
+#include "minimizer.cpp"
+#include "product_construction.cpp"
+#include "antichain_inclusion.cpp"
+#include "equivalence_checker.cpp"
+#include "thread_pool.cpp"
 #include "finite_automata.h"
 
 int main(int argc, char **argv) {
@@ -109,7 +119,16 @@ TEST_F(FiniteAutomataTest, addSymbol) {
 }
 
 TEST_F(FiniteAutomataTest, addSymbolOutOfRange) {
-    ASSERT_THROW(f.addSymbol('['), FiniteAutomataException);
+    ASSERT_THROW(f.addSymbol(FiniteAutomata::EPSILON), FiniteAutomataException);
+}
+
+TEST_F(FiniteAutomataTest, addSymbolAnyByte) {
+    f.addSymbol('[');
+    f.addSymbol('\xff');
+    f.addSymbol('\0');
+    ASSERT_TRUE(f.hasSymbol('['));
+    ASSERT_TRUE(f.hasSymbol('\xff'));
+    ASSERT_TRUE(f.hasSymbol('\0'));
 }
 
 TEST_F(FiniteAutomataTest, addTransition) {
@@ -240,6 +259,89 @@ TEST_F(FiniteAutomataTest, isContained) {
     ASSERT_TRUE(f2.isContained(f));
 }
 
+TEST_F(FiniteAutomataTest, isEquivalentCounterexample) {
+    f.addState("->q0");
+    f.addState("*q1");
+    f.addSymbol('a');
+    f.addTransition("q0", 'a', "q1");
+    f.addTransition("q1", 'a', "q0");
+    FiniteAutomata f2;
+    f2.addState("->q0");
+    f2.addState("*q1");
+    f2.addSymbol('a');
+    f2.addSymbol('b');
+    f2.addTransition("q0", 'a', "q1");
+    f2.addTransition("q1", 'a', "q0");
+    f2.addTransition("q1", 'b', "q1");
+    string counterexample;
+    ASSERT_FALSE(f.isEquivalent(f2, counterexample));
+    ASSERT_EQ(counterexample, "ab");
+    ASSERT_TRUE(f.isContained(f2, counterexample));
+    ASSERT_FALSE(f2.isContained(f, counterexample));
+    ASSERT_EQ(counterexample, "ab");
+}
+
+TEST_F(FiniteAutomataTest, isContainedNonDeterministic) {
+    // (a|b)*a is contained in (a|b)*a(a|b)* but not the other way around
+    f.addState("->q0");
+    f.addState("*q1");
+    f.addSymbol('a');
+    f.addSymbol('b');
+    f.addTransition("q0", 'a', "q0");
+    f.addTransition("q0", 'b', "q0");
+    f.addTransition("q0", 'a', "q1");
+    FiniteAutomata f2;
+    f2.addState("->q0");
+    f2.addState("q1");
+    f2.addState("*q2");
+    f2.addSymbol('a');
+    f2.addSymbol('b');
+    f2.addTransition("q0", 'a', "q0");
+    f2.addTransition("q0", 'b', "q0");
+    f2.addTransition("q0", 'a', "q1");
+    f2.addTransition("q1", FiniteAutomata::EPSILON, "q2");
+    f2.addTransition("q2", 'a', "q2");
+    f2.addTransition("q2", 'b', "q2");
+    string counterexample;
+    ASSERT_TRUE(f.isContained(f2, counterexample));
+    ASSERT_FALSE(f2.isContained(f, counterexample));
+    ASSERT_EQ(counterexample, "ab");
+    ASSERT_FALSE(f.isEquivalent(f2, counterexample));
+    ASSERT_EQ(counterexample, "ab");
+}
+
+TEST_F(FiniteAutomataTest, isContainedAntichain) {
+    // (a|b)*a(a|b)^n, whose deterministic automata has 2^(n+1) states
+    auto nthFromEnd = [](int n) {
+        FiniteAutomata result;
+        result.addSymbol('a');
+        result.addSymbol('b');
+        result.addState("->q0");
+        for (int i = 1; i <= n+1; i++) {
+            result.addState("q"+to_string(i), i == n+1 ? FiniteAutomata::FINAL_STATE : 0);
+        }
+        result.addTransition("q0", 'a', "q0");
+        result.addTransition("q0", 'b', "q0");
+        result.addTransition("q0", 'a', "q1");
+        for (int i = 1; i <= n; i++) {
+            result.addTransition("q"+to_string(i), 'a', "q"+to_string(i+1));
+            result.addTransition("q"+to_string(i), 'b', "q"+to_string(i+1));
+        }
+        return result;
+    };
+    FiniteAutomata f2 = nthFromEnd(40);
+    FiniteAutomata f3 = nthFromEnd(41);
+    string counterexample;
+    ASSERT_TRUE(f2.isContained(f2.doUnion(f3), counterexample));
+    ASSERT_TRUE(f3.isContained(f3.doUnion(f2), counterexample));
+    ASSERT_FALSE(nthFromEnd(6).isContained(nthFromEnd(7), counterexample));
+    ASSERT_EQ(counterexample, string(7, 'a'));
+    ASSERT_FALSE(nthFromEnd(6).doUnion(nthFromEnd(7)).isContained(nthFromEnd(6), counterexample));
+    ASSERT_EQ(counterexample.size(), 8);
+    ASSERT_EQ(counterexample[0], 'a');
+    ASSERT_EQ(counterexample[1], 'b');
+}
+
 TEST_F(FiniteAutomataTest, hasTransition) {
     ASSERT_FALSE(f.hasTransition("q0", 'a', "q1"));
     ASSERT_FALSE(f.hasTransition("q0", 'a', "q2"));
@@ -432,6 +534,36 @@ TEST_F(FiniteAutomataTest, removeDeadStates) {
     ASSERT_FALSE(d.hasState("q3"));
 }
 
+TEST_F(FiniteAutomataTest, trim) {
+    f.addSymbol('a');
+    f.addSymbol('b');
+    f.addState("->q0");
+    f.addState("*q1");
+    f.addState("q2");
+    f.addState("q3");
+    f.addState("*q4");
+    f.addState("q5");
+    f.addTransition("q0", 'a', "q1");
+    f.addTransition("q0", 'b', "q2");
+    f.addTransition("q2", FiniteAutomata::EPSILON, "q1");
+    f.addTransition("q1", 'a', "q3");
+    f.addTransition("q5", 'a', "q4");
+    FiniteAutomata d = f.trim();
+    ASSERT_TRUE(d.hasState("q0"));
+    ASSERT_TRUE(d.hasState("q1"));
+    ASSERT_TRUE(d.hasState("q2"));
+    ASSERT_FALSE(d.hasState("q3"));
+    ASSERT_FALSE(d.hasState("q4"));
+    ASSERT_FALSE(d.hasState("q5"));
+    ASSERT_TRUE(d.isInitialState("q0"));
+    ASSERT_TRUE(d.accepts("b"));
+    shared_ptr<const CompactAutomata> c = f.getCompact();
+    uint32_t q1 = c->findState("q1");
+    ASSERT_EQ(c->predecessors(q1, c->symbolColumn('a')).size(), 1);
+    ASSERT_EQ(*c->predecessors(q1, c->symbolColumn('a')).begin(), c->findState("q0"));
+    ASSERT_EQ(*c->epsilonPredecessors(q1).begin(), c->findState("q2"));
+}
+
 TEST_F(FiniteAutomataTest, removeEquivalentStates) {
     f.addSymbol('a');
     f.addSymbol('b');
@@ -794,3 +926,450 @@ TEST_F(FiniteAutomataTest, generates) {
     ++it;
     ASSERT_FALSE(it !=end);
 }
+
+TEST_F(FiniteAutomataTest, getCompact) {
+    f.addSymbol('a');
+    f.addSymbol('b');
+    f.addState("->q0");
+    f.addState("*q1");
+    f.addState("q2");
+    f.addTransition("q0", 'a', "q1");
+    f.addTransition("q0", 'a', "q2");
+    f.addTransition("q1", FiniteAutomata::EPSILON, "q2");
+    shared_ptr<const CompactAutomata> c = f.getCompact();
+    ASSERT_EQ(c->size(), 3);
+    ASSERT_EQ(c->symbolCount(), 2);
+    uint32_t q0 = c->findState("q0");
+    uint32_t q1 = c->findState("q1");
+    uint32_t q2 = c->findState("q2");
+    ASSERT_EQ(c->initialState(), q0);
+    ASSERT_TRUE(c->isFinalState(q1));
+    ASSERT_FALSE(c->isFinalState(q2));
+    ASSERT_EQ(c->successors(q0, c->symbolColumn('a')).size(), 2);
+    ASSERT_TRUE(c->successors(q0, c->symbolColumn('b')).empty());
+    ASSERT_EQ(c->successor(q1, c->symbolColumn('a')), CompactAutomata::NO_STATE);
+    ASSERT_EQ(*c->epsilonSuccessors(q1).begin(), q2);
+    ASSERT_EQ(c->symbolColumn('c'), CompactAutomata::NO_SYMBOL);
+    ASSERT_FALSE(c->isDeterministic());
+    ASSERT_EQ(f.getCompact(), c);
+    f.addTransition("q2", 'b', "q0");
+    ASSERT_NE(f.getCompact(), c);
+    ASSERT_EQ(f.getCompact()->successor(q2, c->symbolColumn('b')), q0);
+}
+
+TEST_F(FiniteAutomataTest, fromCompact) {
+    CompactAutomata c;
+    uint32_t a = c.addSymbol('a');
+    uint32_t q0 = c.addState("q1");
+    uint32_t q1 = c.addState("", true);
+    c.setInitialState(q0);
+    c.addTransition(q0, a, q1);
+    c.addTransition(q1, a, q1);
+    c.compile();
+    FiniteAutomata d(c);
+    ASSERT_TRUE(d.isInitialState("q1"));
+    ASSERT_TRUE(d.hasState("q0"));
+    ASSERT_TRUE(d.isFinalState("q0"));
+    ASSERT_TRUE(d.hasTransition("q1", 'a', "q0"));
+    ASSERT_TRUE(d.hasTransition("q0", 'a', "q0"));
+    ASSERT_TRUE(d.isDeterministic());
+    ASSERT_TRUE(d.accepts("aaa"));
+    ASSERT_FALSE(d.accepts(""));
+}
+
+TEST_F(FiniteAutomataTest, stateSet) {
+    StateSet a(130), b(130);
+    ASSERT_TRUE(a.empty());
+    ASSERT_TRUE(a.insert(3));
+    ASSERT_FALSE(a.insert(3));
+    ASSERT_TRUE(a.insert(129));
+    ASSERT_TRUE(b.insert(129));
+    ASSERT_NE(a, b);
+    ASSERT_TRUE(b.isSubsetOf(a));
+    ASSERT_TRUE(b.insert(3));
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(a.hash(), b.hash());
+    ASSERT_TRUE(b.insert(64));
+    ASSERT_TRUE(a.unite(b));
+    ASSERT_FALSE(a.unite(b));
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(a.hash(), b.hash());
+    ASSERT_EQ(a.count(), 3);
+    vector<uint32_t> elements = a.elements();
+    ASSERT_EQ(elements.size(), 3);
+    ASSERT_EQ(elements[0], 3);
+    ASSERT_EQ(elements[1], 64);
+    ASSERT_EQ(elements[2], 129);
+    StateSetTable table;
+    ASSERT_EQ(table.insert(a).first, 0);
+    ASSERT_TRUE(table.insert(StateSet(130)).second);
+    ASSERT_FALSE(table.insert(b).second);
+    ASSERT_EQ(table.find(b), 0);
+    ASSERT_EQ(table.size(), 2);
+}
+
+TEST_F(FiniteAutomataTest, determinizeWithoutNames) {
+    // (a|b)*a(a|b)^8, whose deterministic automata has 2^9 states
+    const int n = 8;
+    f.addSymbol('a');
+    f.addSymbol('b');
+    for (int i = 0; i <= n+1; i++) {
+        f.addState("s" + to_string(i), (i == 0 ? FiniteAutomata::INITIAL_STATE : 0) |
+                   (i == n+1 ? FiniteAutomata::FINAL_STATE : 0));
+    }
+    f.addTransition("s0", 'a', "s0");
+    f.addTransition("s0", 'b', "s0");
+    f.addTransition("s0", 'a', "s1");
+    for (int i = 1; i <= n; i++) {
+        f.addTransition("s" + to_string(i), 'a', "s" + to_string(i+1));
+        f.addTransition("s" + to_string(i), 'b', "s" + to_string(i+1));
+    }
+    CompactAutomata d = SubsetConstruction(*f.getCompact()).determinize();
+    ASSERT_TRUE(d.isDeterministic());
+    ASSERT_EQ(d.size(), 1 << (n+1));
+    ASSERT_EQ(d.initialState(), 0);
+    ASSERT_EQ(d.stateName(0), "");
+    FiniteAutomata named = f.determinize();
+    ASSERT_EQ(named.getStates().size(), 1 << (n+1));
+    ASSERT_TRUE(named.isInitialState("[s0]"));
+    ASSERT_TRUE(named.accepts("abbbbbbbb"));
+    ASSERT_FALSE(named.accepts("babbbbbbb"));
+}
+
+TEST_F(FiniteAutomataTest, determinizeParallel) {
+    // (a|b|&)*a(a|b)^6 with an epsilon loop, so every level of the search has
+    // many sets
+    const int n = 6;
+    f.addSymbol('a');
+    f.addSymbol('b');
+    for (int i = 0; i <= n+1; i++) {
+        f.addState("s" + to_string(i), (i == 0 ? FiniteAutomata::INITIAL_STATE : 0) |
+                   (i == n+1 ? FiniteAutomata::FINAL_STATE : 0));
+    }
+    f.addTransition("s0", 'a', "s0");
+    f.addTransition("s0", 'b', "s0");
+    f.addTransition("s0", 'a', "s1");
+    for (int i = 1; i <= n; i++) {
+        f.addTransition("s" + to_string(i), 'a', "s" + to_string(i+1));
+        f.addTransition("s" + to_string(i), 'b', "s" + to_string(i+1));
+    }
+    f.addTransition("s" + to_string(n+1), FiniteAutomata::EPSILON, "s0");
+    SubsetConstruction sequential(*f.getCompact());
+    sequential.setNames(true);
+    CompactAutomata expected = sequential.determinize();
+    for (unsigned threads: {2u, 3u, 8u, 0u}) {
+        SubsetConstruction parallel(*f.getCompact());
+        parallel.setNames(true);
+        parallel.setThreads(threads);
+        CompactAutomata d = parallel.determinize();
+        // The same IDs, names and transitions for any number of threads
+        ASSERT_EQ(d.size(), expected.size());
+        for (uint32_t state = 0; state < d.size(); state++) {
+            ASSERT_EQ(d.stateName(state), expected.stateName(state));
+            ASSERT_EQ(d.isFinalState(state), expected.isFinalState(state));
+            for (uint32_t column = 0; column < d.symbolCount(); column++) {
+                ASSERT_EQ(d.successor(state, column),
+                          expected.successor(state, column));
+            }
+        }
+    }
+    ASSERT_EQ(f.determinize(4).toASCIITable(), f.determinize().toASCIITable());
+
+    ThreadPool pool(4);
+    ASSERT_EQ(pool.size(), 4u);
+    vector<int> done(1000, 0);
+    pool.run(done.size(), [&](size_t task, unsigned worker) {
+        done[task] += worker < pool.size();
+    });
+    ASSERT_EQ(count(done.begin(), done.end(), 1), 1000);
+    ASSERT_THROW(pool.run(10, [](size_t task, unsigned) {
+        if (task == 5) {
+            throw runtime_error("task");
+        }
+    }), runtime_error);
+}
+
+TEST_F(FiniteAutomataTest, removeEquivalentStatesParallel) {
+    // Random partial automata, with 3 symbols and many equivalent states
+    uint32_t seed = 7;
+    auto random = [&](uint32_t limit) {
+        seed = seed*1103515245+12345;
+        return (seed >> 8) % limit;
+    };
+    for (int round = 0; round < 20; round++) {
+        CompactAutomata dfa;
+        for (char symbol: {'a', 'b', 'c'}) {
+            dfa.addSymbol(symbol);
+        }
+        uint32_t n = 1+random(10000);
+        for (uint32_t state = 0; state < n; state++) {
+            dfa.addState("q" + to_string(state), random(4) == 0);
+        }
+        dfa.setInitialState(0);
+        for (uint32_t state = 0; state < n; state++) {
+            for (uint32_t column = 0; column < 3; column++) {
+                if (random(8) != 0) {
+                    dfa.addTransition(state, column, random(n) % (1+random(n)));
+                }
+            }
+        }
+        dfa.compile();
+        vector<uint32_t> expected = Minimizer(dfa).partition();
+        Minimizer parallel(dfa);
+        parallel.setThreads(round % 2 ? 3 : 0);
+        ASSERT_EQ(parallel.partition(), expected);
+    }
+
+    f.addSymbol('a');
+    f.addSymbol('b');
+    f.addState("->q0");
+    f.addState("q1");
+    f.addState("*q2");
+    f.addState("*q3");
+    f.addState("q4");
+    f.addTransition("q0", 'a', "q1");
+    f.addTransition("q0", 'b', "q4");
+    f.addTransition("q1", 'a', "q2");
+    f.addTransition("q4", 'a', "q3");
+    f.addTransition("q2", 'b', "q3");
+    f.addTransition("q3", 'b', "q2");
+    FiniteAutomata d = f.removeEquivalentStates(4);
+    ASSERT_EQ(d.toASCIITable(), f.removeEquivalentStates().toASCIITable());
+    ASSERT_EQ(d.getStates().size(), 3);
+    ASSERT_TRUE(d.hasState("[q1,q4]"));
+}
+
+TEST_F(FiniteAutomataTest, removeEquivalentStatesPartial) {
+    // q1 and q2 only differ in the missing transition, which is equivalent to
+    // the transition of q2 to the dead state q4
+    f.addSymbol('a');
+    f.addSymbol('b');
+    f.addState("->q0");
+    f.addState("q1");
+    f.addState("q2");
+    f.addState("*q3");
+    f.addState("q4");
+    f.addTransition("q0", 'a', "q1");
+    f.addTransition("q0", 'b', "q2");
+    f.addTransition("q1", 'a', "q3");
+    f.addTransition("q2", 'a', "q3");
+    f.addTransition("q2", 'b', "q4");
+    f.addTransition("q4", 'a', "q4");
+    FiniteAutomata d = f.removeEquivalentStates();
+    ASSERT_EQ(d.getStates().size(), 3);
+    ASSERT_TRUE(d.hasState("[q0]"));
+    ASSERT_TRUE(d.hasState("[q1,q2]"));
+    ASSERT_TRUE(d.hasState("[q3]"));
+    ASSERT_FALSE(d.hasState("[q4]"));
+    ASSERT_TRUE(d.isInitialState("[q0]"));
+    ASSERT_TRUE(d.isFinalState("[q3]"));
+    ASSERT_TRUE(d.hasTransition("[q0]", 'a', "[q1,q2]"));
+    ASSERT_TRUE(d.hasTransition("[q0]", 'b', "[q1,q2]"));
+    ASSERT_TRUE(d.hasTransition("[q1,q2]", 'a', "[q3]"));
+    ASSERT_TRUE(d.getTransitions("[q1,q2]", 'b').empty());
+    ASSERT_TRUE(d.isEquivalent(f));
+}
+
+TEST_F(FiniteAutomataTest, doSymmetricDifference) {
+    f.addState("->q0");
+    f.addState("*q1");
+    f.addState("*q2");
+    f.addSymbol('a');
+    f.addTransition("q0", 'a', "q1");
+    f.addTransition("q1", 'a', "q2");
+    FiniteAutomata f2;
+    f2.addState("->q0");
+    f2.addState("*q1");
+    f2.addSymbol('a');
+    f2.addSymbol('b');
+    f2.addTransition("q0", 'a', "q1");
+    f2.addTransition("q0", 'b', "q1");
+    FiniteAutomata f3 = f.doSymmetricDifference(f2);
+    ASSERT_TRUE(f3.isDeterministic());
+    ASSERT_FALSE(f3.accepts(""));
+    ASSERT_FALSE(f3.accepts("a"));
+    ASSERT_TRUE(f3.accepts("b"));
+    ASSERT_TRUE(f3.accepts("aa"));
+    ASSERT_FALSE(f3.accepts("aaa"));
+    ASSERT_TRUE(f3.isInitialState("(q0,q0)"));
+    ASSERT_TRUE(f3.hasTransition("(q0,q0)", 'b', "(-,q1)"));
+}
+
+TEST_F(FiniteAutomataTest, doIntersectionReachablePairs) {
+    // Multiples of 2 and multiples of 3 over a single symbol: only the 6
+    // reachable pairs are created
+    f.addSymbol('a');
+    f.addState("*->p0");
+    f.addState("p1");
+    f.addTransition("p0", 'a', "p1");
+    f.addTransition("p1", 'a', "p0");
+    FiniteAutomata f2;
+    f2.addSymbol('a');
+    f2.addState("*->r0");
+    f2.addState("r1");
+    f2.addState("r2");
+    f2.addTransition("r0", 'a', "r1");
+    f2.addTransition("r1", 'a', "r2");
+    f2.addTransition("r2", 'a', "r0");
+    FiniteAutomata f3 = f.doIntersection(f2);
+    ASSERT_EQ(f3.getStates().size(), 6);
+    ASSERT_TRUE(f3.accepts(""));
+    ASSERT_TRUE(f3.accepts("aaaaaa"));
+    ASSERT_FALSE(f3.accepts("aaaa"));
+    ASSERT_FALSE(f3.accepts("aaa"));
+}
+
+TEST_F(FiniteAutomataTest, productParallel) {
+    // Random partial automata with different alphabets
+    uint32_t seed = 11;
+    auto random = [&](uint32_t limit) {
+        seed = seed*1103515245+12345;
+        return (seed >> 8) % limit;
+    };
+    auto automata = [&](string alphabet) {
+        CompactAutomata dfa;
+        for (char symbol: alphabet) {
+            dfa.addSymbol(symbol);
+        }
+        uint32_t n = 1+random(200);
+        for (uint32_t state = 0; state < n; state++) {
+            dfa.addState("q" + to_string(state), random(3) == 0);
+        }
+        dfa.setInitialState(0);
+        for (uint32_t state = 0; state < n; state++) {
+            for (uint32_t column = 0; column < alphabet.size(); column++) {
+                if (random(6) != 0) {
+                    dfa.addTransition(state, column, random(n));
+                }
+            }
+        }
+        dfa.compile();
+        return dfa;
+    };
+    for (int round = 0; round < 8; round++) {
+        CompactAutomata left = automata("abc"), right = automata("bcd");
+        for (int acceptance: {ProductConstruction::INTERSECTION,
+                ProductConstruction::UNION, ProductConstruction::DIFFERENCE}) {
+            ProductConstruction sequential(left, right, acceptance);
+            sequential.setNames(true);
+            CompactAutomata expected = sequential.build();
+            ProductConstruction parallel(left, right, acceptance);
+            parallel.setNames(true);
+            parallel.setThreads(round % 2 ? 4 : 0);
+            CompactAutomata product = parallel.build();
+            // The same IDs, names and transitions for any number of threads
+            ASSERT_EQ(product.size(), expected.size());
+            for (uint32_t state = 0; state < product.size(); state++) {
+                ASSERT_EQ(product.stateName(state), expected.stateName(state));
+                ASSERT_EQ(product.isFinalState(state), expected.isFinalState(state));
+                for (uint32_t column = 0; column < product.symbolCount(); column++) {
+                    ASSERT_EQ(product.successor(state, column),
+                              expected.successor(state, column));
+                }
+            }
+        }
+    }
+
+    f.addSymbol('a');
+    f.addState("*->p0");
+    f.addState("p1");
+    f.addTransition("p0", 'a', "p1");
+    f.addTransition("p1", 'a', "p0");
+    FiniteAutomata f2;
+    f2.addSymbol('a');
+    f2.addState("*->r0");
+    f2.addState("r1");
+    f2.addState("r2");
+    f2.addTransition("r0", 'a', "r1");
+    f2.addTransition("r1", 'a', "r2");
+    f2.addTransition("r2", 'a', "r0");
+    ASSERT_EQ(f.doIntersection(f2, 3).toASCIITable(),
+              f.doIntersection(f2).toASCIITable());
+}
+
+TEST_F(FiniteAutomataTest, epsilonClosures) {
+    f.addSymbol('a');
+    f.addState("->q0");
+    f.addState("q1");
+    f.addState("q2");
+    f.addState("*q3");
+    f.addTransition("q0", FiniteAutomata::EPSILON, "q1");
+    f.addTransition("q1", FiniteAutomata::EPSILON, "q2");
+    f.addTransition("q2", FiniteAutomata::EPSILON, "q1");
+    f.addTransition("q2", 'a', "q3");
+    shared_ptr<const EpsilonClosure> closures = f.getClosures();
+    shared_ptr<const CompactAutomata> c = f.getCompact();
+    uint32_t q0 = c->findState("q0"), q1 = c->findState("q1");
+    uint32_t q2 = c->findState("q2"), q3 = c->findState("q3");
+    ASSERT_EQ(closures->componentCount(), 3);
+    ASSERT_EQ(closures->component(q1), closures->component(q2));
+    ASSERT_EQ(closures->closure(q0).size(), 3);
+    ASSERT_EQ(closures->closure(q1).size(), 2);
+    ASSERT_EQ(closures->closure(q3).size(), 1);
+    ASSERT_EQ(*closures->closure(q3).begin(), q3);
+    // The closures survive the changes in the other transitions
+    f.addTransition("q3", 'a', "q0");
+    ASSERT_EQ(f.getClosures(), closures);
+    ASSERT_FALSE(f.accepts("aa"));
+    ASSERT_TRUE(f.accepts("aaa"));
+    f.addTransition("q3", FiniteAutomata::EPSILON, "q0");
+    ASSERT_NE(f.getClosures(), closures);
+    ASSERT_EQ(f.getClosures()->closure(q3).size(), 4);
+    ASSERT_TRUE(f.accepts("aaaa"));
+}
+
+TEST_F(FiniteAutomataTest, removeEpsilonTransitions) {
+    f.addSymbol('a');
+    f.addSymbol('b');
+    f.addState("->q0");
+    f.addState("q1");
+    f.addState("*q2");
+    f.addTransition("q0", FiniteAutomata::EPSILON, "q1");
+    f.addTransition("q0", 'b', "q0");
+    f.addTransition("q1", 'a', "q2");
+    f.addTransition("q2", FiniteAutomata::EPSILON, "q0");
+    FiniteAutomata d = f.removeEpsilonTransitions();
+    ASSERT_EQ(d.getStates(), f.getStates());
+    ASSERT_TRUE(d.getTransitions("q0", FiniteAutomata::EPSILON).empty());
+    ASSERT_TRUE(d.getTransitions("q2", FiniteAutomata::EPSILON).empty());
+    ASSERT_TRUE(d.hasTransition("q0", 'a', "q2"));
+    ASSERT_TRUE(d.hasTransition("q2", 'a', "q2"));
+    ASSERT_TRUE(d.hasTransition("q2", 'b', "q0"));
+    ASSERT_TRUE(d.isEquivalent(f));
+}
+
+TEST_F(FiniteAutomataTest, lazyDFA) {
+    // (a|b)*a(a|b)^9, whose deterministic automata has 1024 states
+    f.addSymbol('a');
+    f.addSymbol('b');
+    f.addState("->q0");
+    for (int i = 1; i <= 10; i++) {
+        f.addState("q"+to_string(i), i == 10 ? FiniteAutomata::FINAL_STATE : 0);
+    }
+    f.addTransition("q0", 'a', "q0");
+    f.addTransition("q0", 'b', "q0");
+    f.addTransition("q0", 'a', "q1");
+    for (int i = 1; i < 10; i++) {
+        f.addTransition("q"+to_string(i), 'a', "q"+to_string(i+1));
+        f.addTransition("q"+to_string(i), 'b', "q"+to_string(i+1));
+    }
+    LazyDFA large(f.getCompact(), f.getClosures());
+    LazyDFA small(f.getCompact(), f.getClosures(), 1024);
+    ASSERT_LT(small.cacheCapacity(), 100);
+    string word;
+    uint32_t seed = 1;
+    for (int i = 0; i < 2000; i++) {
+        seed = seed*1103515245+12345;
+        word.push_back(seed & (1 << 16) ? 'a' : 'b');
+        bool expected = word.size() >= 10 && word[word.size()-10] == 'a';
+        ASSERT_EQ(large.accepts(word), expected);
+        ASSERT_EQ(small.accepts(word), expected);
+        ASSERT_EQ(f.accepts(word), expected);
+    }
+    ASSERT_LE(large.cacheSize(), 1024);
+    ASSERT_EQ(large.flushCount(), 0);
+    ASSERT_LE(small.cacheSize(), small.cacheCapacity());
+    ASSERT_GT(small.flushCount(), 0);
+    ASSERT_GT(small.fallbackCount(), 0);
+    ASSERT_FALSE(small.accepts("c"));
+}
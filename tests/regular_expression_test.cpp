@@ -1,5 +1,24 @@
 #include <gtest/gtest.h>
 #include "node.cpp"
+#include "compact_automata.cpp"
+#include "state_set.cpp"
+#include "epsilon_closure.cpp"
+#include "lazy_dfa.cpp"
+#include "subset_construction.cpp"
+#include "minimizer.cpp"
+#include "product_construction.cpp"
+#include "antichain_inclusion.cpp"
+#include "equivalence_checker.cpp"
+#include "thread_pool.cpp"
+#include "glushkov_matcher.cpp"
+#include "thompson_nfa.cpp"
+#include "pike_vm.cpp"
+#include "flat_tree.cpp"
+#include "derivatives.cpp"
+#include "simplifier.cpp"
+#include "expression_dag.cpp"
+#include "byte_classes.cpp"
+#include "utf8_ranges.cpp"
 #include "finite_automata.cpp"
 #include "regular_expression.h"
 
@@ -572,3 +591,665 @@ TEST_F(RegularExpressionTest, getRegularExpression) {
     re = new RegularExpression("(a)*(b)");
     ASSERT_EQ(re->getRegularExpression(), "(a)*(b)");
 }
+
+TEST_F(RegularExpressionTest, accepts) {
+    vector<string> expressions = {"(a|b)*", "1?1?(0?011?)*0?0?",
+        "(a|b)+++++*****?**+a", "", "a(ba)*b?", "((a|b)(a|b))*", "(a?b?)+"};
+    for (string expression : expressions) {
+        RegularExpression r(expression);
+        FiniteAutomata f = r.getAutomata();
+        vector<string> words = {""};
+        for (size_t i = 0; i < words.size() && words[i].size() < 7; i++) {
+            for (char c : string("ab01")) {
+                words.push_back(words[i] + c);
+            }
+        }
+        for (string word : words) {
+            ASSERT_EQ(r.accepts(word), f.accepts(word)) << expression << " " << word;
+        }
+    }
+
+    // 143 positions use the matcher with four words
+    string large = "(a|b)*a";
+    for (int i = 0; i < 70; i++) {
+        large += "(a|b)";
+    }
+    RegularExpression r(large);
+    ASSERT_EQ(r.getPositions().symbols.size(), 143u);
+    ASSERT_TRUE(r.accepts("b" + string(71, 'a')));
+    ASSERT_TRUE(r.accepts("ba" + string(70, 'b')));
+    ASSERT_FALSE(r.accepts("ab" + string(70, 'b')));
+    ASSERT_FALSE(r.accepts(string(70, 'a')));
+
+    // 300 positions use the Thompson automata
+    string huge;
+    for (int i = 0; i < 150; i++) {
+        huge += "(ab)*";
+    }
+    RegularExpression h(huge);
+    ASSERT_EQ(h.getPositions().symbols.size(), 300u);
+    ASSERT_TRUE(h.accepts(""));
+    ASSERT_TRUE(h.accepts("ababab"));
+    ASSERT_FALSE(h.accepts("aba"));
+}
+
+TEST_F(RegularExpressionTest, getPositions) {
+    re = new RegularExpression("a(b|c)*d");
+    GlushkovPositions positions = re->getPositions();
+    ASSERT_EQ(positions.symbols, vector<char>({'a', 'b', 'c', 'd'}));
+    ASSERT_EQ(positions.first.elements(), vector<uint32_t>({0}));
+    ASSERT_FALSE(positions.nullable);
+    ASSERT_EQ(positions.last.elements(), vector<uint32_t>({3}));
+    for (uint32_t position = 0; position < 3; position++) {
+        ASSERT_EQ(positions.follow[position],
+                  vector<uint32_t>({1, 2, 3}));
+    }
+    ASSERT_TRUE(positions.follow[3].empty());
+
+    re = new RegularExpression("(a?b*)+");
+    positions = re->getPositions();
+    ASSERT_TRUE(positions.nullable);
+    ASSERT_EQ(positions.first.elements(), vector<uint32_t>({0, 1}));
+    ASSERT_EQ(positions.last.elements(), vector<uint32_t>({0, 1}));
+    ASSERT_EQ(positions.follow[0], vector<uint32_t>({0, 1}));
+    ASSERT_EQ(positions.follow[1], vector<uint32_t>({0, 1}));
+}
+
+TEST_F(RegularExpressionTest, getNonDeterministicAutomata) {
+    vector<string> expressions = {"(a|b)*", "1?1?(0?011?)*0?0?",
+        "(a|b)+++++*****?**+a", "a(ba)*b?", "((a|b)(a|b))*", "(a?b?)+",
+        "(a*)*b"};
+    for (string expression : expressions) {
+        RegularExpression r(expression);
+        FiniteAutomata f = r.getNonDeterministicAutomata();
+        ASSERT_TRUE(f.isInitialState("q0"));
+        ASSERT_TRUE(f.isEquivalent(r.getAutomata())) << expression;
+
+        PikeVM vm(make_shared<ThompsonNFA>(r.getTree()));
+        for (string word : {"", "a", "b", "ab", "ba", "aab", "0011", "10011",
+                            "abab", "bbbba"}) {
+            ASSERT_EQ(vm.accepts(word), f.accepts(word)) << expression << " " << word;
+        }
+    }
+
+    re = new RegularExpression("a(b|c)*");
+    FiniteAutomata f = re->getNonDeterministicAutomata();
+    ASSERT_EQ(f.getStates().size(), 6u);
+    ASSERT_TRUE(f.hasTransition("q0", 'a', "q1"));
+    ASSERT_TRUE(f.hasTransition("q1", FiniteAutomata::EPSILON, "q2"));
+    ASSERT_TRUE(f.hasTransition("q1", FiniteAutomata::EPSILON, "q3"));
+    ASSERT_TRUE(f.isFinalState("q3"));
+
+    // The empty expression has the empty language
+    RegularExpression empty("");
+    ASSERT_TRUE(empty.getNonDeterministicAutomata().isEmpty());
+    ASSERT_FALSE(PikeVM(make_shared<ThompsonNFA>(empty.getTree())).accepts(""));
+}
+
+TEST_F(RegularExpressionTest, thompsonLinearSize) {
+    // 1000 alternatives of 5 symbols: the automata has one state per node
+    string expression;
+    for (int i = 0; i < 1000; i++) {
+        if (i) {
+            expression += "|";
+        }
+        for (int bit = 0; bit < 5; bit++) {
+            expression += (char) ('a' + ((i >> (2*bit)) & 3));
+        }
+    }
+    RegularExpression r(expression);
+    ThompsonNFA nfa(r.getTree());
+    ASSERT_EQ(nfa.size(), 1000u*5 + 999 + 1);
+
+    PikeVM vm(make_shared<ThompsonNFA>(r.getTree()));
+    ASSERT_TRUE(vm.accepts("aaaaa"));
+    ASSERT_TRUE(vm.accepts("dbcdd"));
+    ASSERT_FALSE(vm.accepts("ddddd"));
+    ASSERT_FALSE(vm.accepts("aaaa"));
+    ASSERT_TRUE(r.accepts("bcdaa"));
+}
+
+TEST_F(RegularExpressionTest, getTreeSyntaxErrors) {
+    vector<pair<string, size_t>> errors = {{"a|", 2}, {"|a", 0}, {"a||b", 2},
+        {"()", 1}, {"*a", 0}, {"(a|*b)", 3}, {"(ab", 0}, {"a(b(c)", 1},
+        {"ab)", 2}, {"a(|b)", 2}};
+    for (auto &error : errors) {
+        RegularExpression r(error.first);
+        try {
+            r.getTree();
+            FAIL() << error.first;
+        } catch (RegularExpressionException &e) {
+            ASSERT_EQ(e.getPosition(), error.second) << error.first;
+        }
+    }
+}
+
+TEST_F(RegularExpressionTest, getTreeAssociativity) {
+    re = new RegularExpression("a|bc|d");
+    Node *tree = re->getTree();
+    ASSERT_EQ(tree->getType(), UNION);
+    ASSERT_EQ(tree->getLeft()->getValue(), 'a');
+    ASSERT_EQ(tree->getRight()->getType(), UNION);
+    ASSERT_EQ(tree->getRight()->getLeft()->getType(), DOT);
+    ASSERT_EQ(tree->getRight()->getLeft()->getLeft()->getValue(), 'b');
+    ASSERT_EQ(tree->getRight()->getLeft()->getRight()->getValue(), 'c');
+    ASSERT_EQ(tree->getRight()->getRight()->getValue(), 'd');
+    ASSERT_EQ(tree->getRight()->getRight()->getParent()->getType(), LAMBDA);
+}
+
+TEST_F(RegularExpressionTest, getTreeLarge) {
+    // 100000 symbols in 20000 groups: parsing is linear
+    string expression;
+    for (int i = 0; i < 20000; i++) {
+        expression += (i % 2) ? "(ab|c)" : "d*";
+    }
+    expression += "(e";
+    for (int i = 0; i < 20000; i++) {
+        expression += "|f";
+    }
+    expression += ")";
+    RegularExpression r(expression);
+    PikeVM vm(make_shared<ThompsonNFA>(r.getTree()));
+    string word;
+    for (int i = 0; i < 5000; i++) {
+        word += "ddabc";
+    }
+    ASSERT_FALSE(vm.accepts(word));
+    ASSERT_TRUE(vm.accepts(word + "f"));
+    ASSERT_TRUE(r.accepts(word + "e"));
+}
+
+TEST_F(RegularExpressionTest, getAutomataSingleSymbol) {
+    re = new RegularExpression("a");
+    FiniteAutomata f = re->getAutomata();
+    ASSERT_EQ(f.getStates().size(), 2u);
+    ASSERT_TRUE(f.hasTransition("q0", 'a', "q1"));
+    ASSERT_TRUE(f.isFinalState("q1"));
+    ASSERT_FALSE(f.isFinalState("q0"));
+}
+
+TEST_F(RegularExpressionTest, getAutomataManyLeaves) {
+    // 2000 alternatives of 5 symbols: the automata is a trie of the words
+    string expression;
+    for (int i = 0; i < 2000; i++) {
+        if (i) {
+            expression += "|";
+        }
+        for (int bit = 0; bit < 5; bit++) {
+            expression += (char) ('a' + ((i >> (2*bit)) & 7) % 6);
+        }
+    }
+    RegularExpression r(expression);
+    ASSERT_EQ(FlatTree(r.getTree()).leafCount(), 10000u);
+    // The common prefixes and suffixes are factored before the automata
+    ASSERT_LT(r.getPositions().symbols.size(), 10000u);
+    FiniteAutomata f = r.getAutomata();
+    ASSERT_TRUE(f.accepts("aaaaa"));
+    ASSERT_FALSE(f.accepts("aaaa"));
+    ASSERT_EQ(f.accepts("fffff"), r.accepts("fffff"));
+    ASSERT_EQ(f.accepts("bcdef"), r.accepts("bcdef"));
+}
+
+TEST_F(RegularExpressionTest, nodeArena) {
+    NodeArena arena;
+    Node *root = arena.create<LambdaNode>('L', 0);
+    Node *previous = root;
+    for (int i = 0; i < 10000; i++) {
+        Node *node = arena.create<LeafNode>('a', root);
+        ASSERT_EQ(node->getType(), LEAF);
+        ASSERT_EQ(node->getParent(), root);
+        if (i < 50) {
+            // The first nodes share the first block, in order
+            ASSERT_GT((char*) node, (char*) previous);
+            ASSERT_LT((char*) node - (char*) previous, 64);
+        }
+        previous = node;
+    }
+    ASSERT_EQ(arena.size(), 10001u);
+    ASSERT_GE(arena.capacity(), 10001u*sizeof(LeafNode));
+    ASSERT_LE(arena.capacity(), 4*10001u*sizeof(LeafNode));
+}
+
+TEST_F(RegularExpressionTest, getTreeOwnership) {
+    Node *tree = re->getTree();
+    ASSERT_EQ(re->getTree(), tree);
+    RegularExpression copy = *re;
+    delete re;
+    re = NULL;
+    // The copy keeps the arena alive
+    ASSERT_EQ(copy.getTree(), tree);
+    ASSERT_EQ(tree->getType(), STAR);
+    ASSERT_EQ(tree->getLeft()->getType(), UNION);
+    ASSERT_TRUE(copy.getAutomata().accepts("abba"));
+}
+
+TEST_F(RegularExpressionTest, flatTree) {
+    vector<string> expressions = {"(a|b)*", "1?1?(0?011?)*0?0?",
+        "(a|b)+++++*****?**+a", "a(ba)*b?", "((a|b)(a|b))*", "(a?b?)+",
+        "(a*)*b", "a", "ab|c(d|e|f)*"};
+    for (string expression : expressions) {
+        RegularExpression r(expression);
+        Node *tree = r.getTree();
+        FlatTree flat(tree);
+
+        // Number the nodes in post-order, like the flat tree
+        map<Node*, uint32_t> indexes;
+        vector<pair<Node*, bool>> visits = {{tree, false}};
+        while (!visits.empty()) {
+            auto visit = visits.back();
+            visits.pop_back();
+            if (!visit.first) {
+                continue;
+            }
+            if (visit.second) {
+                uint32_t next = indexes.size();
+                indexes[visit.first] = next;
+                continue;
+            }
+            visits.push_back(make_pair(visit.first, true));
+            visits.push_back(make_pair(visit.first->getRight(), false));
+            visits.push_back(make_pair(visit.first->getLeft(), false));
+        }
+        ASSERT_EQ(flat.size(), indexes.size()+1);
+        ASSERT_EQ(flat.top(), indexes[tree]);
+        ASSERT_EQ(flat.type(flat.lambda()), LAMBDA);
+
+        // The leaves are numbered from left to right
+        uint32_t leaves = 0;
+        for (auto &node : indexes) {
+            uint32_t i = node.second;
+            ASSERT_EQ(flat.type(i), node.first->getType());
+            ASSERT_EQ(flat.value(i), node.first->getValue());
+            uint32_t left = node.first->getLeft() ?
+                indexes[node.first->getLeft()] : FlatTree::NO_NODE;
+            uint32_t right = node.first->getRight() ?
+                indexes[node.first->getRight()] : FlatTree::NO_NODE;
+            ASSERT_EQ(flat.left(i), left);
+            ASSERT_EQ(flat.right(i), right);
+        }
+        for (uint32_t i = 0; i < flat.lambda(); i++) {
+            if (flat.type(i) == LEAF) {
+                ASSERT_EQ(flat.position(i), leaves++) << expression;
+            }
+        }
+        ASSERT_EQ(flat.leafCount(), leaves);
+    }
+}
+
+TEST_F(RegularExpressionTest, getAutomataExponential) {
+    // The symbol 8 positions from the end is an 'a': 2^9 compositions
+    string expression = "(a|b|c|d)*a";
+    for (int i = 0; i < 8; i++) {
+        expression += "(a|b|c|d)";
+    }
+    RegularExpression r(expression);
+    FiniteAutomata f = r.getAutomata();
+    ASSERT_EQ(f.getStates().size(), 512u);
+    ASSERT_TRUE(f.isDeterministic());
+    ASSERT_TRUE(f.isInitialState("q0"));
+    ASSERT_TRUE(f.hasTransition("q0", 'a', "q1"));
+    ASSERT_TRUE(f.hasTransition("q0", 'b', "q0"));
+    ASSERT_TRUE(f.isEquivalent(r.getNonDeterministicAutomata()));
+}
+
+TEST_F(RegularExpressionTest, derivatives) {
+    vector<string> expressions = {"(a|b)*", "1?1?(0?011?)*0?0?",
+        "(a|b)+++++*****?**+a", "", "a(ba)*b?", "((a|b)(a|b))*", "(a?b?)+",
+        "(a*)*b", "a", "ab|c(d|e|f)*", "(a|b)*a(a|b)(a|b)"};
+    for (string expression : expressions) {
+        RegularExpression r(expression);
+        FiniteAutomata f = r.getAutomata();
+        FiniteAutomata d = r.getDerivativeAutomata();
+        ASSERT_TRUE(d.isDeterministic()) << expression;
+        ASSERT_TRUE(d.isEquivalent(f)) << expression;
+
+        RegularExpression fresh(expression);
+        vector<string> words = {""};
+        for (size_t i = 0; i < words.size() && words[i].size() < 6; i++) {
+            for (char c : string("ab01")) {
+                words.push_back(words[i] + c);
+            }
+        }
+        for (string word : words) {
+            ASSERT_EQ(fresh.acceptsByDerivatives(word), f.accepts(word))
+                << expression << " " << word;
+        }
+    }
+
+    // Hash-consing and the normal form make equal derivatives share an ID
+    re = new RegularExpression("(a|b)*");
+    Derivatives derivatives(re->getTree());
+    uint32_t root = derivatives.root();
+    ASSERT_EQ(derivatives.derive(root, 'a'), root);
+    ASSERT_EQ(derivatives.derive(root, 'b'), root);
+    ASSERT_EQ(derivatives.derive(root, 'c'), Derivatives::NOTHING);
+    ASSERT_TRUE(derivatives.isNullable(root));
+
+    // ACI: the derivatives of (a|b)*a(a|b)^8 are as many as the compositions
+    string expression = "(a|b|c|d)*a";
+    for (int i = 0; i < 8; i++) {
+        expression += "(a|b|c|d)";
+    }
+    RegularExpression r(expression);
+    ASSERT_EQ(r.getDerivativeAutomata().getStates().size(), 512u);
+
+    // A single query only derives by the symbols of the word
+    RegularExpression once(expression);
+    ASSERT_TRUE(once.acceptsByDerivatives("ababababababa"));
+    ASSERT_FALSE(once.acceptsByDerivatives("ab"));
+}
+
+TEST_F(RegularExpressionTest, getSimplifiedTree) {
+    re = new RegularExpression("((a*)*|(a?)*)b");
+    Node *tree = re->getSimplifiedTree();
+    ASSERT_EQ(tree->getValue(), '.');
+    ASSERT_EQ(tree->getLeft()->getValue(), '*');
+    ASSERT_EQ(tree->getLeft()->getLeft()->getValue(), 'a');
+    ASSERT_EQ(tree->getRight()->getValue(), 'b');
+    ASSERT_EQ(re->getTree()->getLeft()->getValue(), '|');
+
+    // ab|ac = a(b|c), ac|bc = (a|b)c and a|ab = ab?
+    RegularExpression prefix("ab|ac");
+    tree = prefix.getSimplifiedTree();
+    ASSERT_EQ(tree->getValue(), '.');
+    ASSERT_EQ(tree->getLeft()->getValue(), 'a');
+    ASSERT_EQ(tree->getRight()->getValue(), '|');
+    RegularExpression suffix("ac|bc");
+    tree = suffix.getSimplifiedTree();
+    ASSERT_EQ(tree->getLeft()->getValue(), '|');
+    ASSERT_EQ(tree->getRight()->getValue(), 'c');
+    RegularExpression optional("a|ab");
+    tree = optional.getSimplifiedTree();
+    ASSERT_EQ(tree->getLeft()->getValue(), 'a');
+    ASSERT_EQ(tree->getRight()->getValue(), '?');
+    ASSERT_EQ(tree->getRight()->getLeft()->getValue(), 'b');
+
+    // The language is kept, with fewer positions
+    vector<string> expressions = {"(a|b)+++++*****?**+a", "(ab|ab|abc)*",
+        "(a?)+b|(a*)?b", "abcd|abce|abd|bcd", "(a|b)(a|b)|(a|b)a"};
+    for (string expression : expressions) {
+        RegularExpression r(expression);
+        FiniteAutomata f = r.getAutomata();
+        ASSERT_TRUE(f.isEquivalent(r.getNonDeterministicAutomata())) << expression;
+        ASSERT_TRUE(f.isEquivalent(
+            FiniteAutomata(Derivatives(r.getTree()).getAutomata()))) << expression;
+        ASSERT_LE(r.getPositions().symbols.size(),
+                  FlatTree(r.getTree()).leafCount()) << expression;
+    }
+    // wh(i(le|ch)|e(n|re)) instead of 19 positions
+    RegularExpression keywords("while|when|where|which");
+    ASSERT_EQ(keywords.getPositions().symbols.size(), 11u);
+    ASSERT_TRUE(keywords.accepts("where"));
+    ASSERT_FALSE(keywords.accepts("wh"));
+}
+
+TEST_F(RegularExpressionTest, expressionDag) {
+    re = new RegularExpression("(ab|c)*(ab|c)*d");
+    ExpressionDag dag(re->getTree());
+    // a, b, ab, c, ab|c, (ab|c)*, d, (ab|c)*d and the whole expression
+    ASSERT_EQ(dag.size(), 9u);
+    ASSERT_EQ(FlatTree(re->getTree()).size(), 16u);
+    uint32_t star = dag.left(dag.root());
+    ASSERT_EQ(dag.type(star), STAR);
+    ASSERT_EQ(dag.left(dag.right(dag.root())), star);
+    ASSERT_EQ(dag.leafCount(star), 3u);
+    ASSERT_TRUE(dag.isNullable(star));
+    ASSERT_EQ(dag.first(star), vector<uint32_t>({0, 2}));
+    ASSERT_EQ(dag.last(star), vector<uint32_t>({1, 2}));
+    ASSERT_EQ(dag.first(dag.root()), vector<uint32_t>({0, 2, 3, 5, 6}));
+    ASSERT_EQ(dag.last(dag.root()), vector<uint32_t>({6}));
+
+    // Each occurrence has its own positions
+    GlushkovPositions positions = dag.positions();
+    ASSERT_EQ(string(positions.symbols.begin(), positions.symbols.end()),
+              "abcabcd");
+    ASSERT_EQ(positions.follow[1],
+              vector<uint32_t>({0, 2, 3, 5, 6}));
+    ASSERT_EQ(positions.follow[4], vector<uint32_t>({3, 5, 6}));
+    ASSERT_TRUE(positions.follow[6].empty());
+
+    // A repeated fragment is shared by all its occurrences
+    string fragment = "(a|b)*c(d|e)?f(gh|ij)+k";
+    string expression;
+    for (int i = 0; i < 50; i++) {
+        expression += "(" + fragment + ")";
+    }
+    RegularExpression r(expression);
+    ExpressionDag shared(r.getTree());
+    ASSERT_LT(shared.size(), FlatTree(r.getTree()).size()/2);
+    ASSERT_EQ(r.getPositions().symbols.size(), 550u);
+    string word;
+    for (int i = 0; i < 50; i++) {
+        word += "abcfijghk";
+    }
+    ASSERT_TRUE(r.accepts(word));
+    ASSERT_FALSE(r.accepts(word + "k"));
+}
+
+TEST_F(RegularExpressionTest, byteClasses) {
+    ByteClasses classes;
+    ASSERT_EQ(classes.count(), 1u);
+    StateSet digits(256), letters(256);
+    for (char c = '0'; c <= '9'; c++) {
+        digits.insert(c);
+    }
+    for (char c = 'a'; c <= 'f'; c++) {
+        letters.insert(c);
+    }
+    letters.insert('5');
+    classes.split(digits);
+    classes.split(letters);
+    // 0-4 and 6-9, 5, a-f and the other bytes
+    ASSERT_EQ(classes.count(), 4u);
+    ASSERT_EQ(classes.representative('9'), '0');
+    ASSERT_EQ(classes.representative('5'), '5');
+    ASSERT_EQ(classes.representative('c'), 'a');
+    ASSERT_EQ(classes.representative('z'), '\0');
+    ASSERT_EQ(classes.representatives(digits), vector<char>({'0', '5'}));
+    ASSERT_EQ(classes.members('7').count(), 9u);
+    ASSERT_EQ(classes.translate("f5z9"), string("a5\0" "0", 4));
+}
+
+TEST_F(RegularExpressionTest, characterClasses) {
+    RegularExpression hex("[a-f0-9]+");
+    ASSERT_TRUE(hex.accepts("deadbeef09"));
+    ASSERT_FALSE(hex.accepts("g"));
+    ASSERT_FALSE(hex.accepts(""));
+    // One position per class, not per byte
+    ASSERT_EQ(hex.getPositions().symbols.size(), 1u);
+    FiniteAutomata f = hex.getAutomata();
+    ASSERT_EQ(f.getAlphabet().size(), 17u);
+    ASSERT_TRUE(f.accepts("c0ffee"));
+    ASSERT_TRUE(f.isEquivalent(hex.getNonDeterministicAutomata()));
+    ASSERT_TRUE(f.isEquivalent(hex.getDerivativeAutomata()));
+
+    RegularExpression any("a.[^x]");
+    ASSERT_TRUE(any.accepts("a\ny"));
+    ASSERT_TRUE(any.accepts(string("a\0\xff", 3)));
+    ASSERT_FALSE(any.accepts("a\nx"));
+    ASSERT_FALSE(any.accepts("a\n"));
+    ASSERT_TRUE(any.acceptsByDerivatives("a\x80z"));
+    ASSERT_FALSE(any.acceptsByDerivatives("b\x80z"));
+
+    RegularExpression escapes("\\(a\\|b\\)\\x41[\\]-]*");
+    ASSERT_TRUE(escapes.accepts("(a|b)A]-]"));
+    ASSERT_FALSE(escapes.accepts("ab"));
+    ASSERT_TRUE(RegularExpression::isTerminal('A'));
+    ASSERT_FALSE(RegularExpression::isTerminal('['));
+
+    // The '&' marks epsilon: it is not a symbol, and the matchers and the
+    // automata agree that no atom reads it
+    for (string expression : {".", "[^a]", "[%-(]", "a.b"}) {
+        RegularExpression r(expression);
+        for (string word : {"&", "a&b", "%", "a%b"}) {
+            bool accepted = r.accepts(word);
+            ASSERT_EQ(r.getAutomata().accepts(word), accepted) << expression;
+            ASSERT_EQ(r.getNonDeterministicAutomata().accepts(word), accepted);
+            ASSERT_EQ(r.getDerivativeAutomata().accepts(word), accepted);
+            ASSERT_EQ(r.acceptsByDerivatives(word), accepted);
+            if (word.find('&') != string::npos) {
+                ASSERT_FALSE(accepted) << expression;
+            }
+        }
+    }
+    ASSERT_TRUE(RegularExpression("[%-(]").accepts("%"));
+    ASSERT_TRUE(RegularExpression("a.b").getAutomata().accepts("a%b"));
+
+    vector<pair<string, size_t>> errors = {{"[a-", 0}, {"a[z-a]", 2},
+        {"a\\", 1}, {"[^\\x00-\\xff]", 0}, {"\\x4", 0}, {"[]", 0},
+        {"a&b", 1}, {"\\x26", 0}, {"[a\\&]", 2}, {"[&-(]", 1}};
+    for (auto &error : errors) {
+        RegularExpression r(error.first);
+        try {
+            r.getTree();
+            FAIL() << error.first;
+        } catch (RegularExpressionException &e) {
+            ASSERT_EQ(e.getPosition(), error.second) << error.first;
+        }
+    }
+}
+
+TEST_F(RegularExpressionTest, utf8Ranges) {
+    typedef Utf8Ranges::ByteRange Range;
+    vector<vector<Range>> expected = {{Range(0xD0, 0xDF), Range(0x80, 0xBF)},
+        {Range(0xE0, 0xE0), Range(0xA0, 0xBF), Range(0x80, 0xBF)},
+        {Range(0xE1, 0xEC), Range(0x80, 0xBF), Range(0x80, 0xBF)},
+        {Range(0xED, 0xED), Range(0x80, 0x9F), Range(0x80, 0xBF)}};
+    ASSERT_EQ(Utf8Ranges::compile(0x400, 0xD7FF), expected);
+    ASSERT_EQ(Utf8Ranges::compile('a', 'z').size(), 1u);
+
+    uint32_t point;
+    ASSERT_EQ(Utf8Ranges::decode("\xe2\x82\xac", 0, point), 3u);
+    ASSERT_EQ(point, 0x20ACu);
+    ASSERT_EQ(Utf8Ranges::decode("\xf0\x9f\x98\x80", 0, point), 4u);
+    ASSERT_EQ(point, 0x1F600u);
+    // Truncated, overlong, surrogate and continuation bytes
+    ASSERT_EQ(Utf8Ranges::decode("\xe2\x82", 0, point), 0u);
+    ASSERT_EQ(Utf8Ranges::decode("\xc0\xaf", 0, point), 0u);
+    ASSERT_EQ(Utf8Ranges::decode("\xed\xa0\x80", 0, point), 0u);
+    ASSERT_EQ(Utf8Ranges::decode("\x80", 0, point), 0u);
+}
+
+TEST_F(RegularExpressionTest, utf8) {
+    RegularExpression accents("[à-ÿ]+", true);
+    ASSERT_TRUE(accents.accepts("éü"));
+    ASSERT_FALSE(accents.accepts("e"));
+    ASSERT_FALSE(accents.accepts("\xc3"));
+    ASSERT_FALSE(accents.accepts("\xc3\xa9\xc3"));
+    ASSERT_TRUE(accents.getAutomata().accepts("àÿ"));
+
+    // A multiplier repeats the whole code point
+    ASSERT_TRUE(RegularExpression("é+", true).accepts("éé"));
+    ASSERT_FALSE(RegularExpression("é+", false).accepts("éé"));
+
+    RegularExpression any("a.b", true);
+    ASSERT_TRUE(any.accepts("a€b"));
+    ASSERT_TRUE(any.accepts("a\xf0\x9f\x98\x80" "b"));
+    ASSERT_FALSE(any.accepts("a\xe2\x82" "b"));
+    ASSERT_FALSE(any.accepts("a\xed\xa0\x80" "b"));
+    ASSERT_FALSE(RegularExpression("a.b").accepts("a€b"));
+
+    RegularExpression other("[^aé]", true);
+    ASSERT_TRUE(other.accepts("ü"));
+    ASSERT_TRUE(other.acceptsByDerivatives("\xf4\x8f\xbf\xbf"));
+    ASSERT_FALSE(other.accepts("é"));
+    ASSERT_FALSE(other.accepts("a"));
+    FiniteAutomata f = other.getAutomata();
+    ASSERT_TRUE(f.isEquivalent(other.getNonDeterministicAutomata()));
+    ASSERT_TRUE(f.isEquivalent(other.getDerivativeAutomata()));
+
+    // The common suffixes of the sequences of '.' are merged
+    RegularExpression dot(".", true);
+    ASSERT_LT(FlatTree(dot.getSimplifiedTree()).leafCount(),
+              FlatTree(dot.getTree()).leafCount());
+    ASSERT_EQ(dot.getAutomata().getStates().size(), 9u);
+
+    RegularExpression invalid("a\xff", true);
+    try {
+        invalid.getTree();
+        FAIL();
+    } catch (RegularExpressionException &e) {
+        ASSERT_EQ(e.getPosition(), 1u);
+    }
+}
+
+TEST_F(RegularExpressionTest, boundedRepetition) {
+    RegularExpression exact("(ab){3}");
+    ASSERT_TRUE(exact.accepts("ababab"));
+    ASSERT_FALSE(exact.accepts("abab"));
+    ASSERT_FALSE(exact.accepts("abababab"));
+
+    RegularExpression range("x[0-9]{2,4}y");
+    ASSERT_FALSE(range.accepts("x1y"));
+    ASSERT_TRUE(range.accepts("x12y"));
+    ASSERT_TRUE(range.accepts("x1234y"));
+    ASSERT_FALSE(range.accepts("x12345y"));
+    FiniteAutomata f = range.getAutomata();
+    ASSERT_TRUE(f.isEquivalent(range.getNonDeterministicAutomata()));
+    ASSERT_TRUE(f.isEquivalent(range.getDerivativeAutomata()));
+    ASSERT_TRUE(f.isEquivalent(
+            RegularExpression("x[0-9][0-9]([0-9][0-9]?)?y").getAutomata()));
+
+    RegularExpression unbounded("a{2,}b{0,}");
+    ASSERT_FALSE(unbounded.accepts("ab"));
+    ASSERT_TRUE(unbounded.accepts("aa"));
+    ASSERT_TRUE(unbounded.accepts("aaaabbb"));
+    ASSERT_TRUE(RegularExpression("ba{0}c").accepts("bc"));
+    ASSERT_TRUE(RegularExpression("a{0}").accepts(""));
+    ASSERT_FALSE(RegularExpression("a{0}").getAutomata().accepts("a"));
+
+    // The optional copies are nested, so each position is followed by at
+    // most one other instead of all the ones after it
+    RegularExpression counted("a{0,255}");
+    ASSERT_TRUE(counted.accepts(string(255, 'a')));
+    ASSERT_FALSE(counted.accepts(string(256, 'a')));
+    GlushkovPositions positions = counted.getPositions();
+    ASSERT_EQ(positions.symbols.size(), 255u);
+    size_t pairs = 0;
+    for (vector<uint32_t> &follow : positions.follow) {
+        pairs += follow.size();
+    }
+    ASSERT_EQ(pairs, 254u);
+    ASSERT_EQ(counted.getAutomata().getStates().size(), 256u);
+
+    RegularExpression nested("(a{10}){10}{10}");
+    nested.setStateBudget(999);
+    try {
+        nested.getTree();
+        FAIL();
+    } catch (RegularExpressionException &e) {
+        ASSERT_EQ(e.getPosition(), 11u);
+    }
+    nested.setStateBudget(1000);
+    ASSERT_EQ(FlatTree(nested.getTree()).leafCount(), 1000u);
+
+    // A repetition near the default budget: its follow lists are linear, and
+    // one more copy is refused
+    size_t budget = RegularExpression::DEFAULT_STATE_BUDGET;
+    RegularExpression large("[a-z]{" + to_string(budget-1) + "}");
+    GlushkovPositions chain = large.getPositions();
+    ASSERT_EQ(chain.symbols.size(), budget-1);
+    ASSERT_EQ(chain.follow[0], vector<uint32_t>({1}));
+    ASSERT_TRUE(chain.follow.back().empty());
+    FiniteAutomata automata = large.getAutomata();
+    ASSERT_EQ(automata.getStates().size(), budget);
+    ASSERT_TRUE(automata.accepts(string(budget-1, 'q')));
+    ASSERT_FALSE(automata.accepts(string(budget-2, 'q')));
+    ASSERT_THROW(RegularExpression("[a-z]{" + to_string(budget+1) + "}").getTree(),
+                 RegularExpressionException);
+
+    vector<pair<string, size_t>> errors = {{"{2}", 0}, {"a{", 1},
+        {"a{x}", 1}, {"a{3,2}", 1}, {"a{,2}", 1}, {"a{2", 1},
+        {"a{1234567890}", 1}, {"(|a{2})", 1}};
+    for (auto &error : errors) {
+        RegularExpression r(error.first);
+        try {
+            r.getTree();
+            FAIL() << error.first;
+        } catch (RegularExpressionException &e) {
+            ASSERT_EQ(e.getPosition(), error.second) << error.first;
+        }
+    }
+    ASSERT_TRUE(RegularExpression("a\\{2}").accepts("a{2}"));
+    ASSERT_FALSE(RegularExpression::isTerminal('{'));
+}
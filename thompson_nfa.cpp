@@ -0,0 +1,141 @@
+#include "thompson_nfa.h"
+
+const uint32_t ThompsonNFA::NO_STATE = UINT32_MAX;
+
+ThompsonNFA::ThompsonNFA(Node *tree) {
+    match = addState(MATCH, 0, NO_STATE, NO_STATE);
+    if (tree->getType() == LAMBDA) {
+        start = NO_STATE;
+    } else {
+        start = compile(tree, match);
+    }
+}
+
+uint32_t ThompsonNFA::addState(Kind kind, char symbol, uint32_t next,
+                               uint32_t alternative) {
+    kinds.push_back(kind);
+    symbols.push_back(symbol);
+    nexts.push_back(next);
+    alternatives.push_back(alternative);
+    return kinds.size()-1;
+}
+
+uint32_t ThompsonNFA::compile(Node *node, uint32_t out) {
+    if (!node) {
+        return out;
+    }
+    uint32_t split, body;
+    vector<Node*> chain;
+    switch (node->getType()) {
+        case LEAF:
+            return addState(SYMBOL, node->getValue(), out, NO_STATE);
+        case DOT:
+            // Concatenations are chains to the right, so long ones are
+            // compiled from the end of the chain without recursing along it
+            for (; node && node->getType() == DOT; node = node->getRight()) {
+                chain.push_back(node->getLeft());
+            }
+            out = compile(node, out);
+            for (size_t i = chain.size(); i-- > 0;) {
+                out = compile(chain[i], out);
+            }
+            return out;
+        case UNION:
+            // Like the concatenations, with a split before each alternative
+            for (; node && node->getType() == UNION; node = node->getRight()) {
+                chain.push_back(node->getLeft());
+            }
+            body = compile(node, out);
+            for (size_t i = chain.size(); i-- > 0;) {
+                split = compile(chain[i], out);
+                body = addState(SPLIT, 0, split, body);
+            }
+            return body;
+        case QUESTION:
+            return addState(SPLIT, 0, compile(node->getLeft(), out), out);
+        case STAR:
+            // The body loops back to the split, which is also the exit
+            split = addState(SPLIT, 0, NO_STATE, out);
+            body = compile(node->getLeft(), split);
+            nexts[split] = body;
+            return split;
+        case PLUS:
+            // Like the star, but entering by the body
+            split = addState(SPLIT, 0, NO_STATE, out);
+            body = compile(node->getLeft(), split);
+            nexts[split] = body;
+            return body;
+        default:
+            return out;
+    }
+}
+
+uint32_t ThompsonNFA::size() const {
+    return kinds.size();
+}
+
+uint32_t ThompsonNFA::initialState() const {
+    return start;
+}
+
+uint32_t ThompsonNFA::finalState() const {
+    return match;
+}
+
+ThompsonNFA::Kind ThompsonNFA::kind(uint32_t state) const {
+    return kinds[state];
+}
+
+char ThompsonNFA::symbol(uint32_t state) const {
+    return symbols[state];
+}
+
+uint32_t ThompsonNFA::next(uint32_t state) const {
+    return nexts[state];
+}
+
+uint32_t ThompsonNFA::alternative(uint32_t state) const {
+    return alternatives[state];
+}
+
+FiniteAutomata ThompsonNFA::toAutomata() const {
+    FiniteAutomata automata;
+    for (uint32_t state = 0; state < size(); state++) {
+        if (kinds[state] == SYMBOL) {
+            automata.addSymbol(symbols[state]);
+        }
+    }
+    if (start == NO_STATE) {
+        automata.addState("q0", FiniteAutomata::INITIAL_STATE);
+        return automata;
+    }
+    vector<string> names(size());
+    vector<uint32_t> order;
+    order.push_back(start);
+    names[start] = "q0";
+    for (size_t i = 0; i < order.size(); i++) {
+        uint32_t state = order[i];
+        for (uint32_t target: {nexts[state], alternatives[state]}) {
+            if (target != NO_STATE && names[target].empty()) {
+                names[target] = "q" + to_string(order.size());
+                order.push_back(target);
+            }
+        }
+    }
+    for (uint32_t state: order) {
+        automata.addState(names[state],
+                          (state == start ? FiniteAutomata::INITIAL_STATE : 0) |
+                          (state == match ? FiniteAutomata::FINAL_STATE : 0));
+    }
+    for (uint32_t state: order) {
+        if (kinds[state] == SYMBOL) {
+            automata.addTransition(names[state], symbols[state], names[nexts[state]]);
+        } else if (kinds[state] == SPLIT) {
+            automata.addTransition(names[state], FiniteAutomata::EPSILON,
+                                   names[nexts[state]]);
+            automata.addTransition(names[state], FiniteAutomata::EPSILON,
+                                   names[alternatives[state]]);
+        }
+    }
+    return automata;
+}
@@ -0,0 +1,129 @@
+#ifndef THOMPSON_NFA_H
+#define THOMPSON_NFA_H
+
+#include "all.h"
+#include "node.h"
+#include "finite_automata.h"
+
+/*!
+ * The epsilon automata of a regular expression built by the construction of
+ * Thompson. Each node of the De Simone tree adds at most one state, so the
+ * automata is linear in the size of the expression (unlike the deterministic
+ * automata, which may be exponential).
+ *
+ * Each state either reads a symbol and goes to the next state, splits (by
+ * epsilon) between the next state and an alternative state, or is the final
+ * state. The automata is stored as parallel arrays indexed by state, like the
+ * instructions of a program.
+ */
+class ThompsonNFA {
+public:
+    /*!
+     * The kinds of states
+     */
+    enum Kind {
+        SYMBOL, //!< Reads the symbol of the state and goes to the next state
+        SPLIT, //!< Goes to the next state and to the alternative state by epsilon
+        MATCH //!< The final state
+    };
+
+    /*!
+     * Constructs the automata of a De Simone tree
+     *
+     * @param tree The tree (or the lambda node alone for the empty language)
+     */
+    explicit ThompsonNFA(Node *tree);
+
+    /*!
+     * Return the number of states
+     *
+     * @return The number of states
+     */
+    uint32_t size() const;
+
+    /*!
+     * Return the initial state
+     *
+     * @return The initial state, or NO_STATE if the language is empty
+     */
+    uint32_t initialState() const;
+
+    /*!
+     * Return the final state
+     *
+     * @return The final state
+     */
+    uint32_t finalState() const;
+
+    /*!
+     * Return the kind of a state
+     *
+     * @param state The state
+     * @return The kind of the state
+     */
+    Kind kind(uint32_t state) const;
+
+    /*!
+     * Return the symbol read by a SYMBOL state
+     *
+     * @param state The state
+     * @return The symbol read by the state
+     */
+    char symbol(uint32_t state) const;
+
+    /*!
+     * Return the next state of a SYMBOL or SPLIT state
+     *
+     * @param state The state
+     * @return The next state
+     */
+    uint32_t next(uint32_t state) const;
+
+    /*!
+     * Return the alternative state of a SPLIT state
+     *
+     * @param state The state
+     * @return The alternative state
+     */
+    uint32_t alternative(uint32_t state) const;
+
+    /*!
+     * Convert this automata to a FiniteAutomata with epsilon transitions,
+     * naming the states q0, q1, ... in the order they are reached from the
+     * initial state
+     *
+     * @return The finite automata
+     */
+    FiniteAutomata toAutomata() const;
+
+    const static uint32_t NO_STATE; //!< The initial state of the empty language
+private:
+    /*!
+     * Add the states of a subtree, whose words continue on a state already
+     * built
+     *
+     * @param node The root of the subtree (NULL is the empty word)
+     * @param out  The state where the words of the subtree continue
+     * @return The first state of the subtree
+     */
+    uint32_t compile(Node *node, uint32_t out);
+
+    /*!
+     * Add a state
+     *
+     * @param kind        The kind of the state
+     * @param symbol      The symbol read by the state
+     * @param next        The next state
+     * @param alternative The alternative state
+     * @return The new state
+     */
+    uint32_t addState(Kind kind, char symbol, uint32_t next, uint32_t alternative);
+
+    vector<Kind> kinds; //!< The kind of each state
+    vector<char> symbols; //!< The symbol of each state
+    vector<uint32_t> nexts; //!< The next state of each state
+    vector<uint32_t> alternatives; //!< The alternative state of each state
+    uint32_t start; //!< The initial state
+    uint32_t match; //!< The final state
+};
+#endif // THOMPSON_NFA_H
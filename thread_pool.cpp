@@ -0,0 +1,96 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned threads): task(nullptr), tasks(0), next(0),
+    generation(0), active(0), stopping(false) {
+    threads = resolve(threads);
+    for (unsigned worker = 1; worker < threads; worker++) {
+        workers.push_back(thread(&ThreadPool::loop, this, worker));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    started.notify_all();
+    for (thread &worker: workers) {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::resolve(unsigned threads) {
+    if (threads == 0) {
+        threads = thread::hardware_concurrency();
+    }
+    return max(threads, 1u);
+}
+
+unsigned ThreadPool::size() const {
+    return workers.size()+1;
+}
+
+void ThreadPool::work(unsigned worker) {
+    for (size_t index = next++; index < tasks; index = next++) {
+        try {
+            (*task)(index, worker);
+        } catch (...) {
+            lock_guard<mutex> guard(lock);
+            if (!error) {
+                error = current_exception();
+            }
+            next = tasks;
+        }
+    }
+}
+
+void ThreadPool::loop(unsigned worker) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> guard(lock);
+            started.wait(guard, [&]() {
+                return stopping || generation != seen;
+            });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        work(worker);
+        lock_guard<mutex> guard(lock);
+        if (--active == 0) {
+            finished.notify_one();
+        }
+    }
+}
+
+void ThreadPool::run(size_t tasks, const function<void(size_t, unsigned)> &function) {
+    if (workers.empty() || tasks <= 1) {
+        for (size_t index = 0; index < tasks; index++) {
+            function(index, 0);
+        }
+        return;
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        task = &function;
+        this->tasks = tasks;
+        next = 0;
+        active = workers.size();
+        error = nullptr;
+        generation++;
+    }
+    started.notify_all();
+    work(0);
+    unique_lock<mutex> guard(lock);
+    finished.wait(guard, [&]() {
+        return active == 0;
+    });
+    task = nullptr;
+    if (error) {
+        exception_ptr thrown = error;
+        error = nullptr;
+        rethrow_exception(thrown);
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "all.h"
+
+/*!
+ * A fixed group of worker threads that run batches of independent tasks.
+ *
+ * Each batch is a range of task indexes, taken one by one from an atomic
+ * counter by the workers and by the thread that runs the batch, so the load
+ * is balanced without any queue. The threads are created once and wait for
+ * the next batch, so algorithms that run many small batches (like one per
+ * level of a breadth-first search) do not pay for creating threads each time.
+ */
+class ThreadPool {
+public:
+    /*!
+     * Constructs a pool with a number of threads, counting the thread that
+     * runs the batches
+     *
+     * @param threads The number of threads, or 0 to use one per core
+     */
+    explicit ThreadPool(unsigned threads);
+
+    /*!
+     * Wait for the workers to finish and destroy them
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /*!
+     * Return the number of threads of the pool, counting the thread that
+     * runs the batches
+     *
+     * @return The number of threads
+     */
+    unsigned size() const;
+
+    /*!
+     * Run a batch of tasks, returning when all of them are finished. If some
+     * task throws an exception, the tasks not started yet are skipped and the
+     * first exception is thrown again here.
+     *
+     * @param tasks    The number of tasks
+     * @param function The function that runs a task, receiving its index and
+     *                 the index of the thread (between 0 and size()-1)
+     */
+    void run(size_t tasks, const function<void(size_t, unsigned)> &function);
+
+    /*!
+     * Resolve a number of threads, where 0 means one per core
+     *
+     * @param threads The number of threads requested
+     * @return The number of threads to use (at least 1)
+     */
+    static unsigned resolve(unsigned threads);
+
+private:
+    /*!
+     * Take and run the tasks of the current batch until there are none left
+     *
+     * @param worker The index of the thread
+     */
+    void work(unsigned worker);
+
+    /*!
+     * The loop of each worker, which waits for the batches
+     *
+     * @param worker The index of the thread
+     */
+    void loop(unsigned worker);
+
+    vector<thread> workers; //!< The threads besides the one that runs the batches
+    mutex lock; //!< Guards the state of the batches
+    condition_variable started; //!< Signals a new batch (or the end)
+    condition_variable finished; //!< Signals that the workers are done
+    const function<void(size_t, unsigned)> *task; //!< The function of the batch
+    size_t tasks; //!< The number of tasks of the batch
+    atomic<size_t> next; //!< The next task to run
+    uint64_t generation; //!< The number of batches started
+    unsigned active; //!< The workers still running the batch
+    bool stopping; //!< If the workers should exit
+    exception_ptr error; //!< The first exception of the batch
+};
+#endif // THREAD_POOL_H
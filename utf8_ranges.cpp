@@ -0,0 +1,110 @@
+#include "utf8_ranges.h"
+
+const uint32_t Utf8Ranges::MAX_CODE_POINT = 0x10FFFF;
+
+const uint32_t Utf8Ranges::FIRST_SURROGATE = 0xD800;
+
+const uint32_t Utf8Ranges::LAST_SURROGATE = 0xDFFF;
+
+size_t Utf8Ranges::decode(const string &text, size_t i, uint32_t &point) {
+    unsigned char lead = text[i];
+    size_t length;
+    uint32_t minimum;
+    if (lead < 0x80) {
+        point = lead;
+        return 1;
+    } else if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        minimum = 0x80;
+        point = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        minimum = 0x800;
+        point = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        minimum = 0x10000;
+        point = lead & 0x07;
+    } else {
+        return 0;
+    }
+    if (i+length > text.size()) {
+        return 0;
+    }
+    for (size_t k = 1; k < length; k++) {
+        unsigned char byte = text[i+k];
+        if ((byte & 0xC0) != 0x80) {
+            return 0;
+        }
+        point = (point << 6) | (byte & 0x3F);
+    }
+    if (point < minimum || point > MAX_CODE_POINT ||
+            (point >= FIRST_SURROGATE && point <= LAST_SURROGATE)) {
+        return 0;
+    }
+    return length;
+}
+
+vector<unsigned char> Utf8Ranges::encode(uint32_t point) {
+    if (point < 0x80) {
+        return {(unsigned char) point};
+    } else if (point < 0x800) {
+        return {(unsigned char) (0xC0 | (point >> 6)),
+                (unsigned char) (0x80 | (point & 0x3F))};
+    } else if (point < 0x10000) {
+        return {(unsigned char) (0xE0 | (point >> 12)),
+                (unsigned char) (0x80 | ((point >> 6) & 0x3F)),
+                (unsigned char) (0x80 | (point & 0x3F))};
+    }
+    return {(unsigned char) (0xF0 | (point >> 18)),
+            (unsigned char) (0x80 | ((point >> 12) & 0x3F)),
+            (unsigned char) (0x80 | ((point >> 6) & 0x3F)),
+            (unsigned char) (0x80 | (point & 0x3F))};
+}
+
+vector<vector<Utf8Ranges::ByteRange>> Utf8Ranges::compile(uint32_t first,
+                                                         uint32_t last) {
+    vector<vector<ByteRange>> result;
+    split(first, last, result);
+    return result;
+}
+
+void Utf8Ranges::split(uint32_t first, uint32_t last,
+                       vector<vector<ByteRange>> &result) {
+    // The last code point of each encoding length
+    for (uint32_t limit: {0x7Fu, 0x7FFu, 0xFFFFu}) {
+        if (first <= limit && limit < last) {
+            split(first, limit, result);
+            split(limit+1, last, result);
+            return;
+        }
+    }
+    if (last < 0x80) {
+        result.push_back(vector<ByteRange>(1, ByteRange(first, last)));
+        return;
+    }
+    // The continuation bytes that differ must cover all their values, so the
+    // range is split where they do not
+    for (uint32_t bits = 6; bits < 24; bits += 6) {
+        uint32_t mask = (1u << bits)-1;
+        if ((first & ~mask) == (last & ~mask)) {
+            continue;
+        }
+        if ((first & mask) != 0) {
+            split(first, first | mask, result);
+            split((first | mask)+1, last, result);
+            return;
+        }
+        if ((last & mask) != mask) {
+            split(first, (last & ~mask)-1, result);
+            split(last & ~mask, last, result);
+            return;
+        }
+    }
+    vector<unsigned char> low = encode(first), high = encode(last);
+    vector<ByteRange> sequence;
+    for (size_t k = 0; k < low.size(); k++) {
+        sequence.push_back(make_pair(low[k], high[k]));
+    }
+    result.push_back(sequence);
+}
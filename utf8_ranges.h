@@ -0,0 +1,69 @@
+#ifndef UTF8_RANGES_H
+#define UTF8_RANGES_H
+
+#include "all.h"
+
+/*!
+ * This class converts ranges of Unicode code points to the sequences of byte
+ * ranges of their UTF-8 encodings, so a Unicode class becomes a union of
+ * concatenations of byte classes and the automata read plain bytes, without
+ * decoding the code points of the words.
+ *
+ * A range is split where the length of the encoding changes and where the
+ * continuation bytes do not cover all their values, so each piece is a
+ * sequence of byte ranges that encodes exactly the code points of the piece.
+ * For example, U+0400 to U+D7FF becomes [D0-DF][80-BF],
+ * [E0][A0-BF][80-BF], [E1-EC][80-BF][80-BF] and [ED][80-9F][80-BF].
+ */
+class Utf8Ranges {
+public:
+    /*!
+     * A range of bytes, with both ends included
+     */
+    typedef pair<unsigned char, unsigned char> ByteRange;
+
+    /*!
+     * Decode the code point encoded at a position of a string
+     *
+     * @param text  The string
+     * @param i     The position of the first byte of the code point
+     * @param point The code point decoded
+     * @return The number of bytes of the code point, or 0 if they are not a
+     *         valid UTF-8 encoding (overlong encodings and surrogates are
+     *         invalid)
+     */
+    static size_t decode(const string &text, size_t i, uint32_t &point);
+
+    /*!
+     * Compile a range of code points, which must not have surrogates
+     *
+     * @param first The first code point of the range
+     * @param last  The last code point of the range
+     * @return The sequences of byte ranges that encode the range
+     */
+    static vector<vector<ByteRange>> compile(uint32_t first, uint32_t last);
+
+    const static uint32_t MAX_CODE_POINT; //!< The last code point
+    const static uint32_t FIRST_SURROGATE; //!< The first surrogate
+    const static uint32_t LAST_SURROGATE; //!< The last surrogate
+private:
+    /*!
+     * Split a range of code points in pieces with the same encoding length
+     * and with full continuation bytes
+     *
+     * @param first  The first code point of the range
+     * @param last   The last code point of the range
+     * @param result The sequences of the pieces
+     */
+    static void split(uint32_t first, uint32_t last,
+                      vector<vector<ByteRange>> &result);
+
+    /*!
+     * Encode a code point
+     *
+     * @param point The code point
+     * @return The bytes of its UTF-8 encoding
+     */
+    static vector<unsigned char> encode(uint32_t point);
+};
+#endif // UTF8_RANGES_H